@@ -0,0 +1,63 @@
+#ifndef async_reactor_header_h
+#define async_reactor_header_h
+
+// SimQL stuff
+#include "database_connection.hpp"
+#include "statement.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <functional>
+
+namespace simql {
+    class async_reactor {
+    private:
+        struct reactor;
+
+    public:
+
+        /* structs */
+
+        // calls are spread round robin over thread_count threads, each polls all of its calls in turn and backs off
+        // from poll_interval towards max_poll_interval while none of them finishes
+        struct alloc_options {
+            std::uint32_t thread_count{1};
+            std::chrono::microseconds poll_interval{100};
+            std::chrono::microseconds max_poll_interval{5000};
+        };
+
+        // runs on the reactor thread with whether the call succeeded, last_error of the statement or connection says why not
+        using completion = std::function<void(bool)>;
+
+        /* constructor/destructor */
+
+        // waits for every call in flight to finish and its completion to run
+        explicit async_reactor(const alloc_options& options);
+        ~async_reactor();
+        async_reactor(const async_reactor&) = delete;
+        async_reactor& operator=(const async_reactor&) = delete;
+
+        /* functions */
+
+        // the call is started and polled on a reactor thread, the statement or connection must outlive it and
+        // must not be touched by anyone else until its completion has run
+        void prepare(statement& stmt, std::string_view sql, completion done);
+        void execute(statement& stmt, completion done);
+        void execute_direct(statement& stmt, std::string_view sql, completion done);
+        void next_record(statement& stmt, completion done);
+        void connect(database_connection& dbc, std::string connection_string, completion done);
+
+        // polls a call that was started elsewhere until it stops reporting pending
+        void watch(std::function<simql_types::async_status()> poll, completion done);
+        std::size_t in_flight();
+
+    private:
+        std::unique_ptr<reactor> m_reactor;
+    };
+}
+
+#endif
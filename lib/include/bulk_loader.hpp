@@ -0,0 +1,73 @@
+#ifndef bulk_loader_header_h
+#define bulk_loader_header_h
+
+// SimQL stuff
+#include "environment.hpp"
+#include "database_connection.hpp"
+#include "statement.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace simql {
+    class bulk_loader {
+    public:
+
+        /* enums */
+        enum class batch_mode : std::uint8_t {
+            parameter_array,
+            multi_row_values
+        };
+
+        /* structs */
+        struct alloc_options {
+            std::uint8_t connection_count{4};
+            std::uint32_t batch_rows{1000};
+            std::uint64_t batch_bytes{4 * 1024 * 1024};
+            std::chrono::milliseconds batch_interval{250};
+            std::uint32_t commit_interval{1};
+            std::size_t queue_capacity{100000};
+            batch_mode mode{batch_mode::parameter_array};
+            std::uint32_t max_statement_parameters{2000};
+        };
+
+        struct statistics {
+            std::uint64_t rows_pushed{0};
+            std::uint64_t rows_committed{0};
+            std::uint64_t rows_failed{0};
+            std::uint64_t bytes_committed{0};
+            std::uint64_t batches_executed{0};
+            std::uint64_t commits{0};
+            std::chrono::steady_clock::duration elapsed{};
+            double rows_per_second() const {
+                auto seconds = std::chrono::duration<double>(elapsed).count();
+                return seconds > 0 ? static_cast<double>(rows_committed) / seconds : 0.0;
+            }
+        };
+
+        /* constructor/destructor */
+        explicit bulk_loader(environment& env, const database_connection::alloc_options& dbc_options, std::string_view connection_string, std::string_view sql, std::vector<statement::sql_parameter_column> layout, const alloc_options& loader_options, const statement::alloc_options& stmt_options);
+        ~bulk_loader();
+        bulk_loader(const bulk_loader&) = delete;
+        bulk_loader& operator=(const bulk_loader&) = delete;
+
+        /* functions */
+        bool push(statement::sql_row row);
+        void finish();
+        statistics stats();
+
+        bool is_valid();
+        std::string last_error();
+
+    private:
+        struct loader;
+        std::unique_ptr<loader> m_loader;
+    };
+}
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef connection_pool_header_h
+#define connection_pool_header_h
+
+// SimQL stuff
+#include "environment.hpp"
+#include "database_connection.hpp"
+#include "statement.hpp"
+#include "simql_constants.hpp"
+#include "simql_types.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <vector>
+
+namespace simql {
+    class connection_pool {
+    private:
+        struct pool;
+
+    public:
+
+        /* structs */
+
+        // connections are opened, validated, trimmed after idle_ttl and replaced when dead on a maintenance thread
+        // every maintenance_interval; acquire only connects on the calling thread when it may not wait
+        // (acquire_timeout of 0) or when the interval is 0 and no maintenance thread runs
+        // every connection the pool opens prepares prepared_statements into its statement cache, which
+        // needs a statement_cache_capacity on the connection options large enough to hold them
+        // once an open fails acquire fails fast rather than waiting, and the maintenance thread retries after a
+        // backoff that doubles from reconnect_min_backoff to reconnect_max_backoff with up to half of it as jitter,
+        // with restore_statements the replacement for a dead connection prepares and binds what it had cached
+        struct alloc_options {
+            std::uint32_t min_size = simql_constants::limits::min_connection_pool_size;
+            std::uint32_t max_size = simql_constants::limits::default_connection_pool_size;
+            std::chrono::milliseconds acquire_timeout{5000};
+            std::chrono::milliseconds idle_ttl{0};
+            std::chrono::milliseconds maintenance_interval{1000};
+            bool validate_on_acquire{true};
+            std::chrono::milliseconds reconnect_min_backoff{100};
+            std::chrono::milliseconds reconnect_max_backoff{30000};
+            bool restore_statements{true};
+            std::vector<std::string> prepared_statements{};
+            statement::alloc_options statement_options{};
+        };
+
+        struct pool_stats {
+            std::size_t idle{0};
+            std::size_t total{0};
+            std::uint64_t opened{0};
+            std::uint64_t failed_opens{0};
+            std::uint64_t dead_replaced{0};
+            std::uint64_t trimmed{0};
+            std::uint64_t restored_statements{0};
+            bool reconnecting{false};
+        };
+
+        // one entry per connection warm_up tried to open, prepared counts the statements now in its cache
+        struct connection_timing {
+            bool connected{false};
+            std::chrono::microseconds connect{0};
+            std::chrono::microseconds prepare{0};
+            std::size_t prepared{0};
+            std::string error{};
+        };
+
+        struct warm_up_report {
+            std::chrono::microseconds elapsed{0};
+            std::size_t opened{0};
+            std::size_t failed{0};
+            std::vector<connection_timing> connections{};
+        };
+
+        // a leased connection goes back to its pool when the lease is destroyed or released
+        class lease {
+        public:
+            lease() = default;
+            ~lease();
+            lease(lease&& other) noexcept;
+            lease& operator=(lease&& other) noexcept;
+            lease(const lease&) = delete;
+            lease& operator=(const lease&) = delete;
+
+            bool is_valid() const;
+            database_connection& connection();
+            database_connection* operator->();
+
+        private:
+            friend class connection_pool;
+            lease(pool* owner, std::unique_ptr<database_connection> conn);
+            void give_back();
+
+            pool* m_owner{nullptr};
+            std::unique_ptr<database_connection> m_connection{};
+        };
+
+        /* constructor/destructor */
+
+        // leases have to be returned before the pool is destroyed
+        explicit connection_pool(environment& env, std::string connection_string, const alloc_options& pool_options, const database_connection::alloc_options& conn_options);
+        ~connection_pool();
+
+        /* functions */
+        void build_pool();
+
+        // opens connections concurrently until count are open, a parallelism of 0 uses one thread per connection
+        warm_up_report warm_up(std::uint32_t count, std::uint32_t parallelism = 0);
+        lease acquire();
+        lease acquire(std::chrono::steady_clock::time_point deadline);
+
+        // an idle connection or an invalid lease right away, ask_for_one has the maintenance thread open a connection
+        // for a later call to pick up when none is idle, the calling thread never connects
+        lease try_acquire(bool ask_for_one);
+        void release(lease&& conn);
+        pool_stats stats();
+
+    private:
+        friend class lease_awaitable;
+
+        // a coroutine queues with the blocking acquires through waiter and polls for its turn, a waiter it stops
+        // polling has to be cancelled
+        simql_types::async_status poll_acquire(std::shared_ptr<void>& waiter, std::chrono::steady_clock::time_point deadline, lease& out);
+        void cancel_acquire(std::shared_ptr<void>& waiter);
+
+        std::unique_ptr<pool> m_pool;
+    };
+}
+
+#endif
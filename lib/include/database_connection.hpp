@@ -3,11 +3,15 @@
 
 // SimQL stuff
 #include "environment.hpp"
+#include "simql_types.hpp"
 
 // STL stuff
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <string_view>
+#include <utility>
+#include <vector>
 
 namespace simql {
     class diagnostic_set;
@@ -22,6 +26,15 @@ namespace simql {
             bool enable_autocommit{true};
             bool enable_tracing{false};
             std::string tracefile{};
+            std::size_t statement_cache_capacity{0};
+        };
+
+        struct statement_cache_stats {
+            std::uint64_t hits{0};
+            std::uint64_t misses{0};
+            std::uint64_t evictions{0};
+            std::size_t size{0};
+            std::size_t capacity{0};
         };
 
         explicit database_connection(environment& env, alloc_options& options);
@@ -32,8 +45,23 @@ namespace simql {
         database_connection& operator=(const database_connection&) = delete;
 
         bool connect(std::string connection_string);
+
+        // returns pending while the driver is still connecting, poll_connect until it is complete or failed
+        simql_types::async_status connect_async(std::string connection_string);
+        simql_types::async_status poll_connect();
+
         bool is_connected();
         void disconnect();
+        bool commit();
+        bool rollback();
+
+        // rolls back whatever transaction a manual-commit session left open
+        bool reset_session();
+
+        // prepared statements are kept per connection in LRU order, a capacity of 0 disables the cache
+        statement_cache_stats statement_cache();
+        void set_statement_cache_capacity(std::size_t capacity);
+        void clear_statement_cache();
 
         bool is_valid();
         std::string_view last_error();
@@ -43,6 +71,9 @@ namespace simql {
         struct handle;
         std::unique_ptr<handle> p_handle;
         friend void* get_dbc_handle(database_connection& dbc) noexcept;
+        friend bool checkout_cached_statement(database_connection& dbc, std::size_t key, std::string_view sql, void*& stmt_handle, std::shared_ptr<void>& plan, simql_types::cursor_attributes& cursor);
+        friend bool checkin_cached_statement(database_connection& dbc, std::size_t key, std::string_view sql, void* stmt_handle, std::shared_ptr<void> plan, const simql_types::cursor_attributes& cursor);
+        friend std::vector<std::pair<std::string, std::shared_ptr<void>>> drain_cached_statements(database_connection& dbc);
     };
 }
 
@@ -0,0 +1,80 @@
+#ifndef hedged_reader_header_h
+#define hedged_reader_header_h
+
+// SimQL stuff
+#include "connection_pool.hpp"
+#include "statement.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <functional>
+
+namespace simql {
+    class hedged_reader {
+    private:
+        struct reader;
+
+    public:
+
+        /* structs */
+
+        // a read still running after the hedge_percentile of the last sample_window reads is issued again on the
+        // next pool (or a second connection of the only one), a read is timed from its start through acquire, prepare
+        // and execute and only counts when its first attempt succeeded, nothing is hedged before min_samples have been seen
+        // and at most max_hedges_in_flight hedges run at once, further ones are skipped
+        struct alloc_options {
+            double hedge_percentile{0.95};
+            std::uint32_t sample_window{256};
+            std::uint32_t min_samples{32};
+            std::chrono::microseconds min_delay{1000};
+            std::uint32_t max_hedges_in_flight{4};
+            statement::alloc_options statement_options{};
+        };
+
+        struct hedge_stats {
+            std::uint64_t reads{0};
+            std::uint64_t hedged{0};
+            std::uint64_t hedge_wins{0};
+            std::uint64_t skipped{0};
+            std::chrono::microseconds hedge_delay{0};
+        };
+
+        struct read_result {
+            bool ok{false};
+            bool hedged{false};
+            bool hedge_won{false};
+            std::string error{};
+        };
+
+        // binds the parameters of a freshly prepared statement, a hedge calls it on its own thread and may do so
+        // while the first attempt's call is still running, so it must only bind values it does not change
+        using binder = std::function<bool(statement&)>;
+
+        // reads the results of whichever attempt finished first, on the calling thread
+        using consumer = std::function<bool(statement&)>;
+
+        /* constructor/destructor */
+
+        // the pools have to outlive the reader, which waits for losing hedges to be cleaned up when destroyed
+        explicit hedged_reader(const std::vector<std::reference_wrapper<connection_pool>>& pools, const alloc_options& options);
+        ~hedged_reader();
+        hedged_reader(const hedged_reader&) = delete;
+        hedged_reader& operator=(const hedged_reader&) = delete;
+
+        /* functions */
+
+        // for idempotent reads only, the losing attempt is cancelled with SQLCancel and its handle recycled
+        read_result execute(std::string_view sql, const binder& bind, const consumer& consume);
+        hedge_stats stats();
+
+    private:
+        std::unique_ptr<reader> m_reader;
+    };
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef load_balancer_header_h
+#define load_balancer_header_h
+
+// SimQL stuff
+#include "connection_pool.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <vector>
+#include <functional>
+
+namespace simql {
+    class load_balancer {
+    private:
+        struct balancer;
+
+    public:
+
+        /* structs */
+
+        // a sample's weight halves every decay_time, a lease that could not be had counts as a sample of failure_penalty
+        struct alloc_options {
+            std::chrono::milliseconds decay_time{10000};
+            std::chrono::milliseconds failure_penalty{1000};
+        };
+
+        struct endpoint_stats {
+            std::chrono::microseconds latency{0};
+            std::uint32_t in_flight{0};
+            std::uint64_t selected{0};
+            std::uint64_t samples{0};
+        };
+
+        // the connection goes back to its pool when the lease is destroyed, latencies recorded on the lease
+        // feed the endpoint's moving average
+        class lease {
+        public:
+            lease() = default;
+            ~lease();
+            lease(lease&& other) noexcept;
+            lease& operator=(lease&& other) noexcept;
+            lease(const lease&) = delete;
+            lease& operator=(const lease&) = delete;
+
+            bool is_valid() const;
+            std::size_t endpoint() const;
+            database_connection& connection();
+            database_connection* operator->();
+            void record(std::chrono::nanoseconds elapsed);
+
+            // runs an execute or fetch and records how long it took
+            template<typename F>
+            auto timed(F&& call) -> decltype(call()) {
+                auto begin = std::chrono::steady_clock::now();
+                auto result = call();
+                record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin));
+                return result;
+            }
+
+        private:
+            friend class load_balancer;
+            lease(balancer* owner, std::size_t endpoint, connection_pool::lease conn);
+            void give_back();
+
+            balancer* m_owner{nullptr};
+            std::size_t m_endpoint{0};
+            connection_pool::lease m_connection{};
+        };
+
+        /* constructor/destructor */
+
+        // the pools have to outlive the balancer and its leases
+        explicit load_balancer(const std::vector<std::reference_wrapper<connection_pool>>& endpoints, const alloc_options& options);
+        ~load_balancer();
+        load_balancer(const load_balancer&) = delete;
+        load_balancer& operator=(const load_balancer&) = delete;
+
+        /* functions */
+
+        // picks the better of two random endpoints by average latency weighted with the leases it has out
+        lease acquire();
+        lease acquire(std::chrono::steady_clock::time_point deadline);
+        std::vector<endpoint_stats> stats();
+
+    private:
+        std::unique_ptr<balancer> m_balancer;
+    };
+}
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef parallel_executor_header_h
+#define parallel_executor_header_h
+
+// SimQL stuff
+#include "connection_pool.hpp"
+#include "statement.hpp"
+#include "simql_constants.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <future>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace simql {
+    class parallel_executor {
+    private:
+        struct executor;
+
+    public:
+
+        /* structs */
+
+        // at most max_parallel_queries queries hold a connection at once, the rest queue in submission order
+        struct alloc_options {
+            std::uint32_t max_parallel_queries = simql_constants::limits::max_parallel_query_count;
+            statement::alloc_options statement_options{};
+        };
+
+        // binds the parameters of the freshly prepared statement, left empty when the SQL takes none
+        using binder = std::function<bool(statement&)>;
+
+        // reads the results on the executor thread that ran the query, before its connection goes back to the pool,
+        // a binder or consumer that throws fails the query like one that returns false
+        using consumer = std::function<bool(statement&)>;
+
+        struct query {
+            std::string sql{};
+            binder bind{};
+            consumer consume{};
+        };
+
+        struct query_result {
+            bool ok{false};
+            std::string error{};
+            std::chrono::microseconds queued{0};
+            std::chrono::microseconds elapsed{0};
+        };
+
+        using completion = std::function<void(query_result)>;
+
+        /* constructor/destructor */
+
+        // the pool has to outlive the executor, which finishes every submitted query before it is destroyed
+        explicit parallel_executor(connection_pool& pool, const alloc_options& options);
+        ~parallel_executor();
+        parallel_executor(const parallel_executor&) = delete;
+        parallel_executor& operator=(const parallel_executor&) = delete;
+
+        /* functions */
+
+        std::future<query_result> submit(query q);
+
+        // the completion runs on the executor thread right after the query's consumer, an exception it throws
+        // is dropped since the result has already been handed over
+        void submit(query q, completion done);
+
+        // runs the batch and returns the results in batch order once all of them are in
+        std::vector<query_result> run(std::vector<query> batch);
+        std::size_t queued();
+
+    private:
+        std::unique_ptr<executor> m_executor;
+    };
+}
+
+#endif
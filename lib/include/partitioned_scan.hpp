@@ -0,0 +1,97 @@
+#ifndef partitioned_scan_header_h
+#define partitioned_scan_header_h
+
+// SimQL stuff
+#include "connection_pool.hpp"
+#include "statement.hpp"
+#include "simql_types.hpp"
+#include "simql_constants.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace simql {
+    class partitioned_scan {
+    private:
+        struct scanner;
+
+    public:
+
+        /* structs */
+
+        // the key range is split into partitions scanned at once, each on its own pooled connection, a partition
+        // hands over one rowset (statement_options.rowset_size rows) at a time and stalls while buffered_rowsets
+        // of them wait for the consumer
+        // with ordered set the rowsets arrive in key order, the partitions cover disjoint key ranges so they are
+        // consumed one after another and the scan runs at the speed of one connection, the partitions behind the
+        // one being consumed only read ahead up to buffered_rowsets each, so an ordered scan wants that raised
+        // to what a partition returns while the one before it drains
+        struct alloc_options {
+            std::uint32_t partitions = simql_constants::limits::max_parallel_query_count;
+            bool ordered{false};
+            std::uint32_t buffered_rowsets{4};
+            statement::alloc_options statement_options{};
+        };
+
+        // max_size is in characters for strings and bytes for blobs
+        struct result_column {
+            std::string name{};
+            simql_types::sql_data_type type{};
+            std::uint32_t max_size{0};
+        };
+
+        // source is whatever may follow FROM and key_column an integer column, ideally indexed, the range between
+        // its MIN and MAX is split evenly unless boundaries name the keys the partitions after the first start at
+        struct scan_spec {
+            std::string source{};
+            std::string key_column{};
+            std::vector<result_column> columns{};
+            std::string filter{};
+            std::vector<std::int64_t> boundaries{};
+        };
+
+        // lower and upper are inclusive
+        struct partition_report {
+            std::int64_t lower{0};
+            std::int64_t upper{0};
+            std::uint64_t rows{0};
+            std::chrono::microseconds elapsed{0};
+            std::string error{};
+        };
+
+        struct scan_report {
+            bool ok{false};
+            std::string error{};
+            std::uint64_t rows{0};
+            std::chrono::microseconds elapsed{0};
+            std::vector<partition_report> partitions{};
+        };
+
+        // runs on the thread that called run, returning false stops the scan, throwing stops it with the
+        // exception as the scan's error
+        using consumer = std::function<bool(std::size_t partition, const std::vector<statement::sql_row>& rowset)>;
+
+        /* constructor/destructor */
+
+        // the pool has to outlive the scan and should hold at least as many connections as there are partitions
+        explicit partitioned_scan(connection_pool& pool, const alloc_options& options);
+        ~partitioned_scan();
+        partitioned_scan(const partitioned_scan&) = delete;
+        partitioned_scan& operator=(const partitioned_scan&) = delete;
+
+        /* functions */
+
+        // the first partition that fails stops the others and the scan
+        scan_report run(const scan_spec& spec, const consumer& consume);
+
+    private:
+        std::unique_ptr<scanner> m_scanner;
+    };
+}
+
+#endif
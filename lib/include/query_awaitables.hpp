@@ -0,0 +1,270 @@
+#ifndef query_awaitables_header_h
+#define query_awaitables_header_h
+
+// SimQL stuff
+#include "async_reactor.hpp"
+#include "connection_pool.hpp"
+#include "database_connection.hpp"
+#include "statement.hpp"
+#include "simql_types.hpp"
+
+// STL stuff
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace simql {
+
+    // --------------------------------------------------
+    // EXECUTORS
+    // --------------------------------------------------
+
+    // whatever polls the calls coroutines are suspended on, a service with its own loop derives from it and
+    // polls from there, the awaitables only ever hand it a call the driver is still running
+    class async_executor {
+    public:
+        using poll_function = std::function<simql_types::async_status()>;
+
+        virtual ~async_executor() = default;
+
+        // poll until the call stops reporting pending, then resume the waiter, may be called from any thread
+        virtual void watch(poll_function poll, std::coroutine_handle<> waiter) = 0;
+    };
+
+    // the default executor, the calls are polled and the coroutines resumed on whichever thread runs the loop
+    class event_loop : public async_executor {
+    private:
+        struct loop;
+
+    public:
+
+        /* structs */
+
+        // all watched calls are polled in turn, backing off from poll_interval towards max_poll_interval while none finishes
+        struct alloc_options {
+            std::chrono::microseconds poll_interval{100};
+            std::chrono::microseconds max_poll_interval{5000};
+        };
+
+        /* constructor/destructor */
+
+        explicit event_loop(const alloc_options& options);
+        ~event_loop() override;
+        event_loop(const event_loop&) = delete;
+        event_loop& operator=(const event_loop&) = delete;
+
+        /* functions */
+
+        void watch(poll_function poll, std::coroutine_handle<> waiter) override;
+
+        // runs until nothing is watched any more
+        void run();
+
+        // polls every watched call once and returns whether any are left
+        bool run_once();
+        std::size_t pending();
+
+    private:
+        std::unique_ptr<loop> m_loop;
+    };
+
+    // resumes the coroutines on the reactor's threads
+    class reactor_executor : public async_executor {
+    public:
+        explicit reactor_executor(async_reactor& reactor) : m_reactor(reactor) {}
+        void watch(poll_function poll, std::coroutine_handle<> waiter) override;
+
+    private:
+        async_reactor& m_reactor;
+    };
+
+    // --------------------------------------------------
+    // AWAITABLES
+    // --------------------------------------------------
+
+    // starts the call when awaited and suspends only while the driver is still running it, resumes with whether
+    // it succeeded, the statement or connection's last_error says why not
+    class query_awaitable {
+    public:
+        query_awaitable(async_executor& executor, async_executor::poll_function start, async_executor::poll_function poll);
+
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> waiter);
+        bool await_resume() const;
+
+    private:
+        async_executor& m_executor;
+        async_executor::poll_function m_start;
+        async_executor::poll_function m_poll;
+        simql_types::async_status m_status{simql_types::async_status::failed};
+    };
+
+    // waits in the pool's queue with the blocking acquires and resumes with the connection handed to it, or an
+    // invalid lease once the deadline passes or the pool is down
+    class lease_awaitable {
+    public:
+        lease_awaitable(async_executor& executor, connection_pool& pool, std::chrono::steady_clock::time_point deadline);
+        ~lease_awaitable();
+        lease_awaitable(const lease_awaitable&) = delete;
+        lease_awaitable& operator=(const lease_awaitable&) = delete;
+
+        bool await_ready();
+        void await_suspend(std::coroutine_handle<> waiter);
+        connection_pool::lease await_resume();
+
+    private:
+        simql_types::async_status try_lease();
+
+        async_executor& m_executor;
+        connection_pool& m_pool;
+        std::chrono::steady_clock::time_point m_deadline;
+        std::shared_ptr<void> m_waiter{};
+        connection_pool::lease m_lease{};
+    };
+
+    query_awaitable async_prepare(statement& stmt, std::string_view sql, async_executor& executor);
+    query_awaitable async_execute(statement& stmt, async_executor& executor);
+    query_awaitable async_execute_direct(statement& stmt, std::string_view sql, async_executor& executor);
+
+    // moves within the current rowset without suspending, only fetching the next rowset does
+    query_awaitable async_next_record(statement& stmt, async_executor& executor);
+    query_awaitable async_connect(database_connection& dbc, std::string connection_string, async_executor& executor);
+
+    // without a deadline it waits for as long as the pool is up
+    lease_awaitable async_acquire(connection_pool& pool, async_executor& executor);
+    lease_awaitable async_acquire(connection_pool& pool, async_executor& executor, std::chrono::steady_clock::time_point deadline);
+
+    // --------------------------------------------------
+    // TASKS
+    // --------------------------------------------------
+
+    // a coroutine that starts right away and can be awaited by another one, for services without a task type of their own
+    // the task owns the coroutine frame and has to outlive it until done
+    template<typename T>
+    class query_task;
+
+    namespace simql_task_detail {
+
+        template<typename T>
+        struct promise;
+
+        template<typename T>
+        struct promise_base {
+            std::coroutine_handle<> continuation{};
+            std::exception_ptr error{};
+
+            // whichever of finishing and being awaited comes second resumes the awaiting coroutine, the task
+            // may finish on an executor thread while it is being awaited
+            std::atomic<bool> handed_over{false};
+
+            std::suspend_never initial_suspend() noexcept { return {}; }
+
+            // a task nobody awaits stays suspended until it is destroyed
+            auto final_suspend() noexcept {
+                struct final_awaiter {
+                    bool await_ready() noexcept { return false; }
+                    std::coroutine_handle<> await_suspend(std::coroutine_handle<promise<T>> self) noexcept {
+                        promise<T>& p = self.promise();
+                        if (p.handed_over.exchange(true, std::memory_order_acq_rel))
+                            return p.continuation;
+                        return std::noop_coroutine();
+                    }
+                    void await_resume() noexcept {}
+                };
+                return final_awaiter{};
+            }
+
+            void unhandled_exception() { error = std::current_exception(); }
+        };
+
+        template<typename T>
+        struct promise : promise_base<T> {
+            std::optional<T> value{};
+            query_task<T> get_return_object();
+            void return_value(T result) { value.emplace(std::move(result)); }
+        };
+
+        template<>
+        struct promise<void> : promise_base<void> {
+            query_task<void> get_return_object();
+            void return_void() {}
+        };
+    }
+
+    template<typename T>
+    class query_task {
+    public:
+        using promise_type = simql_task_detail::promise<T>;
+
+        query_task() = default;
+        explicit query_task(std::coroutine_handle<promise_type> coroutine) : m_coroutine(coroutine) {}
+        ~query_task() {
+            if (m_coroutine)
+                m_coroutine.destroy();
+        }
+        query_task(query_task&& other) noexcept : m_coroutine(std::exchange(other.m_coroutine, nullptr)) {}
+        query_task& operator=(query_task&& other) noexcept {
+            if (this != &other) {
+                if (m_coroutine)
+                    m_coroutine.destroy();
+                m_coroutine = std::exchange(other.m_coroutine, nullptr);
+            }
+            return *this;
+        }
+        query_task(const query_task&) = delete;
+        query_task& operator=(const query_task&) = delete;
+
+        bool done() const {
+            return !m_coroutine || m_coroutine.done();
+        }
+
+        // only once done, rethrows what escaped the coroutine
+        decltype(auto) result() {
+            promise_type& p = m_coroutine.promise();
+            if (p.error)
+                std::rethrow_exception(p.error);
+            if constexpr (!std::is_void_v<T>)
+                return std::move(*p.value);
+        }
+
+        bool await_ready() const {
+            return !m_coroutine;
+        }
+
+        // does not suspend when the task finished in the meantime
+        bool await_suspend(std::coroutine_handle<> waiter) {
+            m_coroutine.promise().continuation = waiter;
+            return !m_coroutine.promise().handed_over.exchange(true, std::memory_order_acq_rel);
+        }
+
+        decltype(auto) await_resume() {
+            return result();
+        }
+
+    private:
+        std::coroutine_handle<promise_type> m_coroutine{};
+    };
+
+    namespace simql_task_detail {
+
+        template<typename T>
+        query_task<T> promise<T>::get_return_object() {
+            return query_task<T>(std::coroutine_handle<promise<T>>::from_promise(*this));
+        }
+
+        inline query_task<void> promise<void>::get_return_object() {
+            return query_task<void>(std::coroutine_handle<promise<void>>::from_promise(*this));
+        }
+    }
+}
+
+#endif
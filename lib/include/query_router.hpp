@@ -0,0 +1,79 @@
+#ifndef query_router_header_h
+#define query_router_header_h
+
+// SimQL stuff
+#include "connection_pool.hpp"
+#include "statement.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace simql {
+    class query_router {
+    private:
+        struct router;
+
+    public:
+
+        /* enums */
+
+        // reads that belong to an open transaction are routed read_write so they see its writes
+        enum class intent : std::uint8_t {
+            read_only,
+            read_write
+        };
+
+        /* structs */
+
+        // every probe_interval each replica is checked on a background thread, an interval of 0 disables probing
+        // lag_probe_sql returns one row with the replica lag in seconds as its first column, a max_replica_lag
+        // of 0 or an empty lag_probe_sql only checks that the replica answers
+        struct alloc_options {
+            std::chrono::milliseconds probe_interval{5000};
+            std::chrono::milliseconds probe_timeout{1000};
+            std::string lag_probe_sql{};
+            std::int64_t max_replica_lag{0};
+            std::uint32_t failures_to_eject{1};
+            std::uint32_t successes_to_restore{2};
+            bool fallback_to_primary{true};
+            statement::alloc_options statement_options{};
+        };
+
+        struct replica_status {
+            bool in_rotation{true};
+            std::int64_t lag{0};
+            std::uint64_t probes{0};
+            std::uint64_t failed_probes{0};
+            std::string last_error{};
+        };
+
+        /* constructor/destructor */
+
+        // the pools have to outlive the router
+        explicit query_router(connection_pool& primary, const std::vector<std::reference_wrapper<connection_pool>>& replicas, const alloc_options& options);
+        ~query_router();
+        query_router(const query_router&) = delete;
+        query_router& operator=(const query_router&) = delete;
+
+        /* functions */
+
+        // read_only goes round robin over the replicas in rotation, and to the primary once none are left
+        // when fallback_to_primary is set, read_write always goes to the primary
+        connection_pool::lease acquire(intent route);
+        connection_pool::lease acquire(intent route, std::chrono::steady_clock::time_point deadline);
+
+        // probes every replica on the calling thread
+        void probe();
+        std::vector<replica_status> replica_statuses();
+
+    private:
+        std::unique_ptr<router> m_router;
+    };
+}
+
+#endif
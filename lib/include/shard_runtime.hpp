@@ -0,0 +1,90 @@
+#ifndef shard_runtime_header_h
+#define shard_runtime_header_h
+
+// SimQL stuff
+#include "environment.hpp"
+#include "database_connection.hpp"
+#include "statement.hpp"
+#include "simql_constants.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace simql {
+    class shard_runtime {
+    private:
+        struct runtime;
+        struct shard;
+
+    public:
+
+        /* structs */
+
+        // a shard_count of 0 runs one shard per hardware thread, shard i is pinned to core i when pin_threads is set
+        // an idle worker polls its inbox spin_count times before it sleeps until the next submit
+        struct alloc_options {
+            std::uint32_t shard_count{0};
+            std::uint32_t connections_per_shard{1};
+            std::uint32_t queue_capacity = simql_constants::limits::default_shard_queue_capacity;
+            std::uint32_t statement_cache_size = simql_constants::limits::default_shard_statement_cache_size;
+            std::uint32_t spin_count{256};
+            bool pin_threads{true};
+        };
+
+        // what a task sees while it runs on its shard, none of it may be touched from another thread
+        class context {
+        public:
+            std::uint32_t shard_index() const;
+            std::size_t connection_count() const;
+            database_connection& connection(std::size_t index = 0);
+
+            // prepared on first use and kept in the shard's LRU cache with its cursor closed between uses,
+            // the reference holds until the entry is evicted, nullptr when the SQL could not be prepared
+            statement* prepared(std::string_view sql, std::size_t connection_index = 0);
+            std::string_view last_error();
+
+            bool submit(std::uint32_t shard, std::function<void(context&)> work);
+
+        private:
+            friend class shard_runtime;
+            explicit context(shard* owner);
+            shard* m_shard;
+        };
+
+        // a task that throws is cut short there and leaves the message in its shard's last_error
+        using task = std::function<void(context&)>;
+
+        /* constructor/destructor */
+
+        // every shard connects its own connections on its own thread, the constructor returns once all have tried
+        explicit shard_runtime(environment& env, std::string connection_string, const alloc_options& runtime_options, const database_connection::alloc_options& conn_options, const statement::alloc_options& stmt_options);
+
+        // queued tasks still run before the workers exit, including those of a submit that was under way, a submit
+        // that starts once the destructor has begun is refused, also one made from a task
+        ~shard_runtime();
+        shard_runtime(const shard_runtime&) = delete;
+        shard_runtime& operator=(const shard_runtime&) = delete;
+
+        /* functions */
+
+        // lock-free from any thread, false when the shard's inbox is full or the runtime is shutting down
+        bool submit(std::uint32_t shard, task work);
+
+        std::uint32_t shard_count() const;
+
+        // the context of the shard running on the calling thread, nullptr off the runtime's threads
+        static context* current();
+
+        bool is_valid();
+        std::string_view last_error();
+
+    private:
+        std::unique_ptr<runtime> m_runtime;
+    };
+}
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef simql_binding_header_h
+#define simql_binding_header_h
+
+// SimQL stuff
+#include "simql_types.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// OS stuff
+#include "os_inclusions.hpp"
+
+// ODBC stuff
+#include <sqltypes.h>
+#include <sqlext.h>
+#include <sql.h>
+
+namespace simql_binding {
+
+    /* STRUCTS */
+
+    // everything SQLBindParameter needs that is known from the C++ type alone
+    struct parameter_plan {
+        SQLSMALLINT c_type;
+        SQLSMALLINT sql_type;
+        SQLULEN column_size;
+        SQLSMALLINT decimal_digits;
+        SQLLEN buffer_length;
+        bool is_variable;
+    };
+
+    // the per-call part of a binding, length is the byte count for variable types, 0 for fixed types or SQL_NULL_DATA
+    struct bound_value {
+        SQLPOINTER data;
+        SQLLEN length;
+    };
+
+    /* TYPE MAPPING */
+
+    template<typename T>
+    struct parameter_traits;
+
+    template<typename T, SQLSMALLINT C, SQLSMALLINT S, SQLULEN Size = 0, SQLSMALLINT Digits = 0>
+    struct fixed_parameter_traits {
+        static constexpr parameter_plan plan{C, S, Size, Digits, sizeof(T), false};
+        static bound_value bind(const T& value) noexcept { return bound_value{const_cast<T*>(&value), 0}; }
+    };
+
+    static_assert(sizeof(bool) == sizeof(SQLCHAR), "SQL_C_BIT is bound directly to bool");
+
+    template<> struct parameter_traits<bool>                            : fixed_parameter_traits<bool, SQL_C_BIT, SQL_BIT> {};
+    template<> struct parameter_traits<std::int8_t>                     : fixed_parameter_traits<std::int8_t, SQL_C_STINYINT, SQL_TINYINT> {};
+    template<> struct parameter_traits<std::int16_t>                    : fixed_parameter_traits<std::int16_t, SQL_C_SSHORT, SQL_SMALLINT> {};
+    template<> struct parameter_traits<std::int32_t>                    : fixed_parameter_traits<std::int32_t, SQL_C_SLONG, SQL_INTEGER> {};
+    template<> struct parameter_traits<std::int64_t>                    : fixed_parameter_traits<std::int64_t, SQL_C_SBIGINT, SQL_BIGINT> {};
+    template<> struct parameter_traits<float>                           : fixed_parameter_traits<float, SQL_C_FLOAT, SQL_REAL> {};
+    template<> struct parameter_traits<double>                          : fixed_parameter_traits<double, SQL_C_DOUBLE, SQL_DOUBLE> {};
+    template<> struct parameter_traits<simql_types::guid_struct>        : fixed_parameter_traits<simql_types::guid_struct, SQL_C_GUID, SQL_GUID> {};
+    template<> struct parameter_traits<simql_types::datetime_struct>    : fixed_parameter_traits<simql_types::datetime_struct, SQL_C_TYPE_TIMESTAMP, SQL_TYPE_TIMESTAMP, 29, 9> {};
+    template<> struct parameter_traits<simql_types::date_struct>        : fixed_parameter_traits<simql_types::date_struct, SQL_C_TYPE_DATE, SQL_TYPE_DATE, 10> {};
+    template<> struct parameter_traits<simql_types::time_struct>        : fixed_parameter_traits<simql_types::time_struct, SQL_C_TYPE_TIME, SQL_TYPE_TIME, 8> {};
+
+    template<>
+    struct parameter_traits<char> {
+        static constexpr parameter_plan plan{SQL_C_CHAR, SQL_CHAR, 1, 0, sizeof(char), false};
+        static bound_value bind(const char& value) noexcept { return bound_value{const_cast<char*>(&value), sizeof(char)}; }
+    };
+
+    // narrow strings are passed through as UTF-8 bytes
+    template<>
+    struct parameter_traits<std::string_view> {
+        static constexpr parameter_plan plan{SQL_C_CHAR, SQL_VARCHAR, 0, 0, 0, true};
+        static bound_value bind(const std::string_view& value) noexcept { return bound_value{const_cast<char*>(value.data()), static_cast<SQLLEN>(value.size())}; }
+    };
+
+    template<>
+    struct parameter_traits<std::string> {
+        static constexpr parameter_plan plan{SQL_C_CHAR, SQL_VARCHAR, 0, 0, 0, true};
+        static bound_value bind(const std::string& value) noexcept { return bound_value{const_cast<char*>(value.data()), static_cast<SQLLEN>(value.size())}; }
+    };
+
+    template<>
+    struct parameter_traits<std::vector<std::uint8_t>> {
+        static constexpr parameter_plan plan{SQL_C_BINARY, SQL_VARBINARY, 0, 0, 0, true};
+        static bound_value bind(const std::vector<std::uint8_t>& value) noexcept { return bound_value{const_cast<std::uint8_t*>(value.data()), static_cast<SQLLEN>(value.size())}; }
+    };
+
+    // an empty optional is bound as NULL
+    template<typename T>
+    struct parameter_traits<std::optional<T>> {
+        static constexpr parameter_plan plan = parameter_traits<T>::plan;
+        static bound_value bind(const std::optional<T>& value) noexcept {
+            return value.has_value() ? parameter_traits<T>::bind(*value) : bound_value{const_cast<std::optional<T>*>(&value), SQL_NULL_DATA};
+        }
+    };
+
+    template<typename T>
+    concept bindable = requires(const std::remove_cvref_t<T>& value) {
+        { parameter_traits<std::remove_cvref_t<T>>::plan } -> std::convertible_to<parameter_plan>;
+        { parameter_traits<std::remove_cvref_t<T>>::bind(value) } -> std::same_as<bound_value>;
+    };
+
+}
+
+#endif
@@ -18,9 +18,22 @@ namespace simql_constants {
     namespace limits {
         static constexpr std::uint8_t max_sql_column_name_size              = 255;
         static constexpr std::uint8_t max_parallel_query_count              = 8;
-        static constexpr std::uint8_t max_statement_handle_pool_size        = 16;
-        static constexpr std::uint8_t min_statement_handle_pool_size        = 4;
+        static constexpr std::uint32_t max_statement_handle_pool_size       = 4096;
+        static constexpr std::uint32_t default_statement_handle_pool_size   = 16;
+        static constexpr std::uint32_t min_statement_handle_pool_size       = 4;
+        static constexpr std::uint32_t max_statement_handles_per_connection = 1024;
+        static constexpr std::uint8_t max_thread_statement_cache_size       = 2;
+        static constexpr std::uint32_t max_connection_pool_size             = 256;
+        static constexpr std::uint32_t default_connection_pool_size         = 8;
+        static constexpr std::uint32_t min_connection_pool_size             = 1;
+        static constexpr std::uint32_t max_connection_warm_up_threads       = 32;
+        static constexpr std::uint32_t default_shard_queue_capacity         = 1024;
+        static constexpr std::uint32_t default_shard_statement_cache_size   = 64;
+        static constexpr std::uint32_t max_async_reactor_threads            = 64;
         static constexpr std::uint16_t max_error_fetches                    = 2048;
+        static constexpr std::uint32_t default_stream_chunk_size            = 65536;
+        static constexpr std::uint32_t max_bounded_char_parameter_size     = 8000;
+        static constexpr std::uint32_t max_bounded_wchar_parameter_size    = 4000;
     }
 
 }
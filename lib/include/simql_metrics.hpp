@@ -0,0 +1,101 @@
+#ifndef simql_metrics_header_h
+#define simql_metrics_header_h
+
+// STL stuff
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace simql_metrics {
+
+    /* ENUMS */
+
+    enum class counter : std::uint8_t {
+        pool_hits,
+        pool_misses,
+        pool_exhausted,
+        handles_allocated,
+        handles_freed,
+        executes,
+        fetches,
+        rows_fetched,
+        bytes_fetched,
+        count
+    };
+
+    enum class timer : std::uint8_t {
+        acquire_wait,
+        odbc_alloc_handle,
+        odbc_prepare,
+        odbc_execute,
+        odbc_exec_direct,
+        odbc_fetch,
+        odbc_more_results,
+        count
+    };
+
+    /* CONSTANTS */
+
+    static constexpr std::size_t counter_count = static_cast<std::size_t>(counter::count);
+    static constexpr std::size_t timer_count = static_cast<std::size_t>(timer::count);
+
+    // counters are striped so threads on different cores rarely touch the same cache line
+    static constexpr std::size_t stripe_count = 16;
+
+    // bucket i counts durations up to and including 2^i nanoseconds, the last bucket everything longer
+    static constexpr std::size_t bucket_count = 40;
+
+    /* STRUCTS */
+
+    struct histogram_snapshot {
+        std::array<std::uint64_t, bucket_count> buckets{};
+        std::uint64_t count{0};
+        std::uint64_t sum_ns{0};
+    };
+
+    struct metrics_snapshot {
+        std::array<std::uint64_t, counter_count> counters{};
+        std::array<histogram_snapshot, timer_count> timers{};
+    };
+
+    /* FUNCTIONS */
+
+    // collection is on by default, turning it off skips the clock reads around ODBC calls as well
+    inline std::atomic<bool> enabled_flag{true};
+
+    inline bool enabled() noexcept {
+        return enabled_flag.load(std::memory_order_relaxed);
+    }
+
+    void set_enabled(bool enabled) noexcept;
+    void add(counter c, std::uint64_t value = 1) noexcept;
+    void record(timer t, std::chrono::nanoseconds elapsed) noexcept;
+    void reset() noexcept;
+
+    // the stripes and buckets are read one at a time, so a snapshot taken under load is not a single point in time
+    metrics_snapshot snapshot();
+
+    // Prometheus text exposition format
+    std::string to_text(const metrics_snapshot& snap);
+
+    // writes through a temporary file and renames it so a scraper never reads a partial dump
+    bool write_text(const std::filesystem::path& path);
+
+    // runs an ODBC call and records its latency
+    template<typename F>
+    auto timed(timer t, F&& call) -> decltype(call()) {
+        if (!enabled())
+            return call();
+
+        auto begin = std::chrono::steady_clock::now();
+        auto rc = call();
+        record(t, std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin));
+        return rc;
+    }
+}
+
+#endif
@@ -0,0 +1,207 @@
+#ifndef simql_queues_header_h
+#define simql_queues_header_h
+
+// STL stuff
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+namespace simql_queues {
+
+    /* CONSTANTS */
+
+    // keeps the producer and consumer cursors off each other's cache line
+    static constexpr std::size_t cache_line_size = 64;
+
+    /* CLASSES */
+
+    // bounded multi-producer multi-consumer ring, each cell carries a sequence number that tells
+    // producers and consumers whose turn it is, so neither side ever takes a lock (D. Vyukov)
+    template<typename T> requires std::is_nothrow_move_assignable_v<T> && std::is_default_constructible_v<T>
+    class mpmc_ring {
+    private:
+
+        struct cell {
+            std::atomic<std::size_t> sequence;
+            T value;
+        };
+
+        std::unique_ptr<cell[]> m_cells;
+        std::size_t m_mask;
+        alignas(cache_line_size) std::atomic<std::size_t> m_enqueue_pos{0};
+        alignas(cache_line_size) std::atomic<std::size_t> m_dequeue_pos{0};
+
+    public:
+
+        // the capacity is rounded up to a power of two
+        explicit mpmc_ring(std::size_t capacity) {
+            std::size_t size = std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity);
+            m_cells = std::make_unique<cell[]>(size);
+            m_mask = size - 1;
+            for (std::size_t i = 0; i < size; i++)
+                m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        mpmc_ring(const mpmc_ring&) = delete;
+        mpmc_ring& operator=(const mpmc_ring&) = delete;
+
+        bool try_push(T value) noexcept {
+            std::size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            while (true) {
+                cell& c = m_cells[pos & m_mask];
+                std::size_t sequence = c.sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos);
+                if (diff == 0) {
+                    if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        c.value = std::move(value);
+                        c.sequence.store(pos + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        bool try_pop(T& value) noexcept {
+            std::size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            while (true) {
+                cell& c = m_cells[pos & m_mask];
+                std::size_t sequence = c.sequence.load(std::memory_order_acquire);
+                std::ptrdiff_t diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(pos + 1);
+                if (diff == 0) {
+                    if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        value = std::move(c.value);
+                        c.sequence.store(pos + m_mask + 1, std::memory_order_release);
+                        return true;
+                    }
+                } else if (diff < 0) {
+                    return false;
+                } else {
+                    pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        std::size_t capacity() const noexcept {
+            return m_mask + 1;
+        }
+
+        // only a hint while other threads are pushing or popping
+        std::size_t size_approx() const noexcept {
+            std::size_t enqueued = m_enqueue_pos.load(std::memory_order_relaxed);
+            std::size_t dequeued = m_dequeue_pos.load(std::memory_order_relaxed);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+    };
+
+
+    // bounded multi-producer multi-consumer stack, the most recently pushed value is popped first, the nodes live in
+    // one array and both the stack and its free list are linked by index under a tagged head so a node popped and
+    // pushed again between a thread's load and its compare-exchange cannot be mistaken for the old head (ABA)
+    template<typename T> requires std::is_nothrow_move_assignable_v<T> && std::is_default_constructible_v<T>
+    class lifo_stack {
+    private:
+
+        static constexpr std::uint32_t npos = std::numeric_limits<std::uint32_t>::max();
+
+        struct node {
+            std::atomic<std::uint32_t> next{npos};
+            T value;
+        };
+
+        std::unique_ptr<node[]> m_nodes;
+        std::size_t m_capacity;
+        alignas(cache_line_size) std::atomic<std::uint64_t> m_top;
+        alignas(cache_line_size) std::atomic<std::uint64_t> m_free;
+        alignas(cache_line_size) std::atomic<std::size_t> m_size{0};
+
+        static constexpr std::uint64_t pack(std::uint32_t index, std::uint32_t tag) noexcept {
+            return (static_cast<std::uint64_t>(tag) << 32) | index;
+        }
+
+        static constexpr std::uint32_t index_of(std::uint64_t head) noexcept {
+            return static_cast<std::uint32_t>(head);
+        }
+
+        static constexpr std::uint32_t tag_of(std::uint64_t head) noexcept {
+            return static_cast<std::uint32_t>(head >> 32);
+        }
+
+        // the next index read may be stale once another thread won the node, the tag then fails the exchange
+        std::uint32_t pop_node(std::atomic<std::uint64_t>& head) noexcept {
+            std::uint64_t current = head.load(std::memory_order_acquire);
+            while (true) {
+                std::uint32_t index = index_of(current);
+                if (index == npos)
+                    return npos;
+
+                std::uint32_t next = m_nodes[index].next.load(std::memory_order_relaxed);
+                if (head.compare_exchange_weak(current, pack(next, tag_of(current) + 1), std::memory_order_acq_rel, std::memory_order_acquire))
+                    return index;
+            }
+        }
+
+        void push_node(std::atomic<std::uint64_t>& head, std::uint32_t index) noexcept {
+            std::uint64_t current = head.load(std::memory_order_relaxed);
+            do {
+                m_nodes[index].next.store(index_of(current), std::memory_order_relaxed);
+            } while (!head.compare_exchange_weak(current, pack(index, tag_of(current) + 1), std::memory_order_release, std::memory_order_relaxed));
+        }
+
+    public:
+
+        explicit lifo_stack(std::size_t capacity) : m_capacity(capacity < 1 ? std::size_t{1} : capacity) {
+            m_nodes = std::make_unique<node[]>(m_capacity);
+            for (std::size_t i = 0; i + 1 < m_capacity; i++)
+                m_nodes[i].next.store(static_cast<std::uint32_t>(i + 1), std::memory_order_relaxed);
+            m_top.store(pack(npos, 0), std::memory_order_relaxed);
+            m_free.store(pack(0, 0), std::memory_order_relaxed);
+        }
+
+        lifo_stack(const lifo_stack&) = delete;
+        lifo_stack& operator=(const lifo_stack&) = delete;
+
+        // the size is counted before the node is published, so a pop can never take it below zero
+        bool try_push(T value) noexcept {
+            std::uint32_t index = pop_node(m_free);
+            if (index == npos)
+                return false;
+
+            m_nodes[index].value = std::move(value);
+            m_size.fetch_add(1, std::memory_order_relaxed);
+            push_node(m_top, index);
+            return true;
+        }
+
+        bool try_pop(T& value) noexcept {
+            std::uint32_t index = pop_node(m_top);
+            if (index == npos)
+                return false;
+
+            m_size.fetch_sub(1, std::memory_order_relaxed);
+            value = std::move(m_nodes[index].value);
+            push_node(m_free, index);
+            return true;
+        }
+
+        std::size_t capacity() const noexcept {
+            return m_capacity;
+        }
+
+        // only a hint while other threads are pushing or popping
+        std::size_t size_approx() const noexcept {
+            return m_size.load(std::memory_order_relaxed);
+        }
+    };
+
+}
+
+#endif
@@ -43,6 +43,7 @@ namespace simql_returncodes {
         error_stmt_execute,
         error_stmt_column_calc,
         error_stmt_no_columns,
+        error_stmt_stream_data,
         error_col_binding,
         error_col_invalid_dtype
 
@@ -78,6 +79,7 @@ namespace {
         {simql_returncodes::code::error_stmt_execute,               std::string_view("could not execute the sql statement")},
         {simql_returncodes::code::error_stmt_column_calc,           std::string_view("could not calculate the result set's column count")},
         {simql_returncodes::code::error_stmt_no_columns,            std::string_view("there are no columns in the result set")},
+        {simql_returncodes::code::error_stmt_stream_data,           std::string_view("could not send the streamed parameter data")},
         {simql_returncodes::code::error_col_binding,                std::string_view("could not bind the current column")},
         {simql_returncodes::code::error_col_invalid_dtype,          std::string_view("coudl not bind the column to the returned data type")}
     };
@@ -2,6 +2,7 @@
 #define simql_strings_header_h
 
 // STL stuff
+#include <exception>
 #include <string>
 #include <string_view>
 #include <memory>
@@ -24,6 +25,9 @@ namespace simql_strings {
     SQLCHAR to_odbc_char_n(char utf8);
     char from_odbc_char(SQLWCHAR odbc);
     char from_odbc_char(SQLCHAR odbc);
+
+    // describes what a user callback threw, for the error of the work it failed
+    std::string from_exception(std::exception_ptr error);
 }
 
 #endif
\ No newline at end of file
@@ -19,8 +19,39 @@ namespace simql_types {
         output
     };
 
+    enum class sql_data_type : std::uint8_t {
+        string,
+        wide_string,
+        character,
+        boolean,
+        float64,
+        float32,
+        int8,
+        int16,
+        int32,
+        int64,
+        guid,
+        datetime,
+        date,
+        time,
+        blob
+    };
+
+    // outcome of starting or polling an asynchronous call
+    enum class async_status : std::uint8_t {
+        complete,
+        pending,
+        failed
+    };
+
     /* STRUCTS */
 
+    // the cursor attributes a statement handle holds, a driver that cannot honour a value substitutes one it supports
+    struct cursor_attributes {
+        std::uint32_t rowset_size{0};
+        bool is_scrollable{false};
+    };
+
     struct datetime_struct {
         std::int16_t year;
         std::uint16_t month;
@@ -122,14 +153,17 @@ namespace simql_types {
         template<sql_variant_type T>
         sql_value(T value) : data(value) {}
 
-        constexpr bool is_null() { return std::holds_alternative<std::monostate>(data); }
+        constexpr bool is_null() const { return std::holds_alternative<std::monostate>(data); }
         void set_null() { data = std::monostate{}; }
 
         template<sql_variant_type T>
         void set(T value) { data = value; }
 
         template<sql_variant_type T>
-        T get() {
+        constexpr bool holds() const { return std::holds_alternative<T>(data); }
+
+        template<sql_variant_type T>
+        T get() const {
             return std::visit([&](auto const& x) -> T {
                 using X = std::decay_t<decltype(x)>;
                 if constexpr (std::is_same_v<X, T>)
@@ -139,6 +173,18 @@ namespace simql_types {
             }, data);
         }
 
+        std::size_t byte_size() const {
+            return std::visit([&](auto const& x) -> std::size_t {
+                using X = std::decay_t<decltype(x)>;
+                if constexpr (std::is_same_v<X, std::monostate>)
+                    return 0;
+                else if constexpr (std::is_same_v<X, std::string> || std::is_same_v<X, std::vector<std::uint8_t>>)
+                    return x.size();
+                else
+                    return sizeof(X);
+            }, data);
+        }
+
     };
 
 }
@@ -4,12 +4,19 @@
 // SimQL stuff
 #include "database_connection.hpp"
 #include "simql_types.hpp"
+#include "simql_constants.hpp"
+#include "simql_binding.hpp"
 
 // STL stuff
+#include <array>
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <concepts>
 #include <type_traits>
+#include <functional>
+#include <filesystem>
 
 namespace simql {
     class diagnostic_set;
@@ -193,6 +200,30 @@ namespace simql {
             sql_parameter_blob(std::uint8_t _position, simql_types::parameter_binding_type _binding_type, std::vector<std::uint8_t> _value, std::uint32_t _max_byte_count, bool _variadic = false) : sql_parameter(_position, _binding_type, _value), max_byte_count(_max_byte_count), variadic(_variadic) {}
         };
 
+        // input-only parameter sent at execution time in fixed size chunks (SQL_DATA_AT_EXEC)
+        // the source writes up to 'capacity' bytes and returns the count, 0 at the end or < 0 on failure
+        // rewind, when set, runs before every execution so a source aborted mid-stream starts over
+        struct sql_parameter_stream {
+            using chunk_source = std::function<std::int64_t(std::uint8_t* buffer, std::size_t capacity)>;
+            std::uint8_t position{};
+            chunk_source source{};
+            std::function<void()> rewind{};
+            std::int64_t total_length{-1};
+            std::uint32_t chunk_size{simql_constants::limits::default_stream_chunk_size};
+            bool is_text{false};
+            sql_parameter_stream(std::uint8_t _position, chunk_source _source, std::int64_t _total_length = -1, bool _is_text = false) : position(_position), source(std::move(_source)), total_length(_total_length), is_text(_is_text) {}
+            static sql_parameter_stream from_file(std::uint8_t position, const std::filesystem::path& path, bool is_text = false);
+            static sql_parameter_stream from_memory(std::uint8_t position, const std::uint8_t* data, std::size_t size, bool is_text = false);
+        };
+
+        // column-wise description of an array bound parameter set, max_size is in characters for strings and bytes for blobs
+        struct sql_parameter_column {
+            simql_types::sql_data_type type{};
+            std::uint32_t max_size{};
+            sql_parameter_column(simql_types::sql_data_type _type, std::uint32_t _max_size = 0) : type(_type), max_size(_max_size) {}
+        };
+        using sql_row = std::vector<simql_types::sql_value>;
+
         // --------------------------------------------------
         // LIFECYCLE
         // --------------------------------------------------
@@ -211,6 +242,23 @@ namespace simql {
         bool prepare(std::string_view sql);
         bool execute();
         bool execute_direct(std::string_view sql);
+        bool execute_batch(const std::vector<sql_parameter_column>& layout, const std::vector<sql_row>& rows);
+
+        // may be called from another thread while execute runs, the interrupted call then fails with SQLSTATE HY008
+        bool cancel();
+
+        // --------------------------------------------------
+        // ASYNCHRONOUS EXECUTION
+        // --------------------------------------------------
+
+        // each call returns pending while the driver still runs it, poll until it is complete or failed before
+        // touching the statement again, drivers without SQL_ATTR_ASYNC_ENABLE run the call synchronously instead
+        simql_types::async_status prepare_async(std::string_view sql);
+        simql_types::async_status execute_async();
+        simql_types::async_status execute_direct_async(std::string_view sql);
+        simql_types::async_status next_record_async();
+        simql_types::async_status poll();
+        bool is_pending();
 
         // --------------------------------------------------
         // RESULT NAVIGATION
@@ -220,6 +268,9 @@ namespace simql {
         bool last_record();
         bool prev_record();
         bool next_record();
+
+        // set once a fetch ran past the last row, navigation then returns false without an error
+        bool at_end();
         bool next_result_set();
         bool goto_bound_parameters();
 
@@ -234,7 +285,9 @@ namespace simql {
         // --------------------------------------------------
 
         template<typename... T> requires (std::derived_from<std::remove_cvref_t<T>, sql_column> && ...)
-        bool define_columns(T&... columns);
+        bool define_columns(T&... columns) {
+            return (add_column(columns) && ...);
+        }
 
         // --------------------------------------------------
         // PARAMETER BINDING
@@ -242,6 +295,28 @@ namespace simql {
 
         template<typename... T> requires (std::derived_from<std::remove_cvref_t<T>, sql_parameter> && ...)
         bool bind_parameters(T&... parameters);
+        bool bind_stream(sql_parameter_stream& parameter);
+
+        // binds input parameters in order from the arguments, whose C/SQL types are resolved at compile time
+        // the arguments are bound in place and must outlive the execution
+        template<typename... T> requires (simql_binding::bindable<T> && ...)
+        bool bind(T&... args) {
+            static constexpr std::array<simql_binding::parameter_plan, sizeof...(T)> plans{simql_binding::parameter_traits<std::remove_cvref_t<T>>::plan...};
+            const std::array<simql_binding::bound_value, sizeof...(T)> values{simql_binding::parameter_traits<std::remove_cvref_t<T>>::bind(args)...};
+            return bind_plan(plans.data(), values.data(), sizeof...(T));
+        }
+
+        // the arguments may be temporaries, so their bindings are released again once the execution returns, that
+        // resets every parameter of the handle, so the call is refused while bind_stream or bind_parameters bound any
+        template<typename... T> requires (sizeof...(T) > 0 && (simql_binding::bindable<T> && ...))
+        bool execute(const T&... args) {
+            if (!only_typed_bindings())
+                return false;
+
+            bool is_executed = bind(args...) && execute();
+            release_typed_bindings();
+            return is_executed;
+        }
 
         // --------------------------------------------------
         // DIAGNOSTICS
@@ -253,8 +328,28 @@ namespace simql {
 
     private:
         friend class statement_pool;
-        statement(void* raw_stmt_handle, database_connection& conn, void* pool);
-        void* detach_handle() noexcept;
+        friend class shard_runtime;
+        friend bool restore_cached_statement(database_connection& dbc, const alloc_options& options, std::string_view sql, std::shared_ptr<void> plan);
+        statement(void* raw_stmt_handle, database_connection* conn, void* pool, const alloc_options& options, const simql_types::cursor_attributes& cursor, std::string_view sql = {}, std::shared_ptr<void> plan = nullptr);
+        void* detach_handle(std::string& sql, std::shared_ptr<void>& plan, database_connection*& conn, simql_types::cursor_attributes& cursor);
+        void reset_execution_state();
+        bool bind_plan(const simql_binding::parameter_plan* plans, const simql_binding::bound_value* values, std::size_t count);
+        bool only_typed_bindings();
+        void release_typed_bindings();
+        bool add_column(sql_column_string& column);
+        bool add_column(sql_column_character& column);
+        bool add_column(sql_column_boolean& column);
+        bool add_column(sql_column_double& column);
+        bool add_column(sql_column_float& column);
+        bool add_column(sql_column_int8& column);
+        bool add_column(sql_column_int16& column);
+        bool add_column(sql_column_int32& column);
+        bool add_column(sql_column_int64& column);
+        bool add_column(sql_column_guid& column);
+        bool add_column(sql_column_datetime& column);
+        bool add_column(sql_column_date& column);
+        bool add_column(sql_column_time& column);
+        bool add_column(sql_column_blob& column);
         struct handle;
         std::unique_ptr<handle> p_handle;
     };
@@ -9,34 +9,86 @@
 
 // STL stuff
 #include <cstdint>
+#include <array>
 #include <memory>
 #include <chrono>
+#include <string_view>
+#include <vector>
+#include <functional>
 
 namespace simql {
     class statement_pool {
     public:
 
+        /* enums */
+
+        // exhausted acquires are served strictly by priority class, first come first served within a class
+        enum class priority : std::uint8_t {
+            interactive,
+            normal,
+            batch
+        };
+
+        /* constants */
+        static constexpr std::size_t priority_count = 3;
+        static constexpr std::size_t depth_bucket_count = 12;
+        static constexpr std::array<std::chrono::microseconds, 10> wait_time_bounds{{
+            std::chrono::microseconds(50), std::chrono::microseconds(100), std::chrono::microseconds(250),
+            std::chrono::microseconds(500), std::chrono::microseconds(1000), std::chrono::microseconds(2500),
+            std::chrono::microseconds(5000), std::chrono::microseconds(10000), std::chrono::microseconds(50000),
+            std::chrono::microseconds(250000)
+        }};
+
         /* structs */
+
+        // idle_ttl trimming and pre-warming for the peak demand within demand_window run on a
+        // maintenance thread every maintenance_interval, an interval of 0 disables both
+        // min_size and max_size span every connection of the pool, a max of 0 leaves only the per-connection limits
         struct alloc_options {
-            std::uint8_t min_size = simql_constants::limits::min_statement_handle_pool_size;
-            std::uint8_t max_size = simql_constants::limits::max_statement_handle_pool_size;
+            std::uint32_t min_size = simql_constants::limits::min_statement_handle_pool_size;
+            std::uint32_t max_size = simql_constants::limits::default_statement_handle_pool_size;
+            std::uint32_t min_per_connection{0};
+            std::uint32_t max_per_connection = simql_constants::limits::max_statement_handles_per_connection;
             std::chrono::milliseconds acquire_timeout{0};
             std::chrono::milliseconds idle_ttl{0};
+            std::chrono::milliseconds maintenance_interval{1000};
+            std::chrono::milliseconds demand_window{30000};
+            std::uint8_t thread_cache_size = simql_constants::limits::max_thread_statement_cache_size;
+        };
+
+        // per priority class, wait_buckets[i] counts waits that ended within wait_time_bounds[i] and the last bucket everything slower,
+        // depth_buckets[0] counts arrivals at an empty queue and depth_buckets[i] those that found 2^(i-1) to 2^i - 1 waiters ahead
+        struct wait_stats {
+            std::size_t queue_depth{0};
+            std::uint64_t served{0};
+            std::uint64_t timed_out{0};
+            std::array<std::uint64_t, wait_time_bounds.size() + 1> wait_buckets{};
+            std::array<std::uint64_t, depth_bucket_count> depth_buckets{};
         };
 
         /* constructor/destructor */
         explicit statement_pool(database_connection& conn, const alloc_options& pool_options, const statement::alloc_options& stmt_options);
+
+        // handles are allocated on the least loaded connection, acquire serves prepared handles from any of them
+        explicit statement_pool(const std::vector<std::reference_wrapper<database_connection>>& connections, const alloc_options& pool_options, const statement::alloc_options& stmt_options);
         ~statement_pool();
 
         /* functions */
         void build_pool();
         statement acquire();
+
+        // waits in the queue of its priority class until the deadline when the pool is exhausted, a deadline in the past never waits
+        statement acquire(priority prio, std::chrono::steady_clock::time_point deadline);
+
+        // returns a handle that already has the SQL prepared and its columns bound when one is idle, otherwise prepares one
+        statement acquire(std::string_view sql);
+        statement acquire(std::string_view sql, priority prio, std::chrono::steady_clock::time_point deadline);
         void release(statement&& stmt);
+        std::array<wait_stats, priority_count> wait_statistics();
 
     private:
         struct pool;
         std::unique_ptr<pool> m_pool;
-        database_connection& m_conn;
     };
 }
 
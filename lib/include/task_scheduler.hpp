@@ -0,0 +1,105 @@
+#ifndef task_scheduler_header_h
+#define task_scheduler_header_h
+
+// SimQL stuff
+#include "connection_pool.hpp"
+#include "database_connection.hpp"
+#include "simql_constants.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <future>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace simql {
+    class task_scheduler {
+    private:
+        struct scheduler;
+        struct task_state;
+
+    public:
+
+        /* structs */
+
+        // every worker keeps its own deque of submitted tasks, runs them oldest first and steals the oldest from the
+        // other workers once it runs dry, continuations stay on the worker that queued them and run before its next
+        // submitted task, with hold_connections set a worker keeps the connection it leased until the scheduler
+        // stops, otherwise it goes back to the pool once a task and its continuations on that worker are done
+        struct alloc_options {
+            std::uint32_t workers = simql_constants::limits::max_parallel_query_count;
+            bool hold_connections{true};
+        };
+
+        // tasks counts the submitted task and every continuation it queued
+        struct task_result {
+            bool ok{false};
+            std::string error{};
+            std::uint64_t tasks{0};
+            std::chrono::microseconds elapsed{0};
+        };
+
+        struct statistics {
+            std::uint64_t executed{0};
+            std::uint64_t stolen{0};
+            std::size_t queued{0};
+        };
+
+        class context;
+
+        // returning false or throwing fails the submitted task and drops its continuations that have not started yet
+        using task = std::function<bool(context&)>;
+        using completion = std::function<void(task_result)>;
+
+        // handed to a task while it runs on a worker thread
+        class context {
+        public:
+            // the worker's connection, leased on first use, nullptr when the pool has none to give
+            database_connection* connection();
+            std::size_t worker() const;
+
+            // queues a continuation on this worker, e.g. decoding a rowset the task just fetched, it is never stolen
+            // and sees the same connection, the submitted task only completes once all of its continuations have
+            void then(task next);
+
+            // the error reported when the task returns false
+            void fail(std::string error);
+
+        private:
+            friend struct scheduler;
+            context(scheduler* owner, std::size_t worker, std::shared_ptr<task_state> state);
+
+            scheduler* m_owner{nullptr};
+            std::size_t m_worker{0};
+            std::shared_ptr<task_state> m_state{};
+            std::string m_error{};
+        };
+
+        /* constructor/destructor */
+
+        // the pool has to outlive the scheduler, which finishes every submitted task before it is destroyed
+        explicit task_scheduler(connection_pool& pool, const alloc_options& options);
+        ~task_scheduler();
+        task_scheduler(const task_scheduler&) = delete;
+        task_scheduler& operator=(const task_scheduler&) = delete;
+
+        /* functions */
+
+        std::future<task_result> submit(task t);
+
+        // the completion runs on the worker thread that finished the last of the task's continuations
+        void submit(task t, completion done);
+
+        // runs the batch and returns the results in batch order once all of them are in
+        std::vector<task_result> run(std::vector<task> batch);
+        statistics stats();
+
+    private:
+        std::unique_ptr<scheduler> m_scheduler;
+    };
+}
+
+#endif
@@ -0,0 +1,201 @@
+// SimQL stuff
+#include "async_reactor.hpp"
+#include "database_connection.hpp"
+#include "statement.hpp"
+#include "simql_types.hpp"
+#include "simql_constants.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <algorithm>
+
+namespace simql {
+
+    // a call is started once and polled until it stops reporting pending
+    struct async_operation {
+        std::function<simql_types::async_status()> start;
+        std::function<simql_types::async_status()> poll;
+        async_reactor::completion done;
+    };
+
+    struct reactor_thread {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<async_operation> inbox;
+        bool stopping{false};
+        std::thread thread;
+    };
+
+    struct async_reactor::reactor {
+        async_reactor::alloc_options opts;
+        std::vector<std::unique_ptr<reactor_thread>> threads;
+        std::atomic<std::size_t> next{0};
+        std::atomic<std::size_t> in_flight{0};
+
+        explicit reactor(const async_reactor::alloc_options& options) : opts(options) {
+            opts.thread_count = std::clamp<std::uint32_t>(opts.thread_count, 1, simql_constants::limits::max_async_reactor_threads);
+            if (opts.poll_interval.count() <= 0)
+                opts.poll_interval = std::chrono::microseconds(1);
+            if (opts.max_poll_interval < opts.poll_interval)
+                opts.max_poll_interval = opts.poll_interval;
+
+            threads.reserve(opts.thread_count);
+            for (std::uint32_t i = 0; i < opts.thread_count; i++)
+                threads.push_back(std::make_unique<reactor_thread>());
+            for (std::unique_ptr<reactor_thread>& t : threads)
+                t->thread = std::thread([this, worker = t.get()]() { run(*worker); });
+        }
+
+        ~reactor() {
+            for (std::unique_ptr<reactor_thread>& t : threads) {
+                {
+                    std::lock_guard<std::mutex> lock(t->mutex);
+                    t->stopping = true;
+                }
+                t->wake.notify_one();
+            }
+
+            for (std::unique_ptr<reactor_thread>& t : threads) {
+                if (t->thread.joinable())
+                    t->thread.join();
+            }
+        }
+
+        void submit(async_operation op) {
+            in_flight.fetch_add(1, std::memory_order_relaxed);
+            reactor_thread& t = *threads[next.fetch_add(1, std::memory_order_relaxed) % threads.size()];
+            {
+                std::lock_guard<std::mutex> lock(t.mutex);
+                t.inbox.push_back(std::move(op));
+            }
+            t.wake.notify_one();
+        }
+
+        void finish(async_operation& op, simql_types::async_status status) {
+            if (op.done)
+                op.done(status == simql_types::async_status::complete);
+            in_flight.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        void run(reactor_thread& t) {
+            std::vector<async_operation> active;
+            std::deque<async_operation> incoming;
+            std::chrono::microseconds interval = opts.poll_interval;
+            bool progressed{false};
+
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(t.mutex);
+                    if (active.empty())
+                        t.wake.wait(lock, [&]() { return t.stopping || !t.inbox.empty(); });
+                    else if (!progressed)
+                        t.wake.wait_for(lock, interval, [&]() { return !t.inbox.empty(); });
+
+                    // stopping only ends the thread once nothing it took on is left
+                    if (t.stopping && t.inbox.empty() && active.empty())
+                        return;
+
+                    incoming.swap(t.inbox);
+                }
+
+                progressed = false;
+                for (async_operation& op : incoming) {
+                    simql_types::async_status status = op.start();
+                    if (status == simql_types::async_status::pending) {
+                        active.push_back(std::move(op));
+                    } else {
+                        finish(op, status);
+                        progressed = true;
+                    }
+                }
+                incoming.clear();
+
+                for (std::size_t i = 0; i < active.size();) {
+                    simql_types::async_status status = active[i].poll();
+                    if (status == simql_types::async_status::pending) {
+                        i++;
+                        continue;
+                    }
+
+                    async_operation op = std::move(active[i]);
+                    active[i] = std::move(active.back());
+                    active.pop_back();
+                    finish(op, status);
+                    progressed = true;
+                }
+
+                // back off while the calls are all still running, start over as soon as one of them finishes
+                interval = progressed ? opts.poll_interval : std::min(interval * 2, opts.max_poll_interval);
+            }
+        }
+    };
+
+    // --------------------------------------------------
+    // REACTOR
+    // --------------------------------------------------
+
+    async_reactor::async_reactor(const async_reactor::alloc_options& options) : m_reactor(std::make_unique<reactor>(options)) {}
+
+    async_reactor::~async_reactor() = default;
+
+    void async_reactor::prepare(statement& stmt, std::string_view sql, async_reactor::completion done) {
+        m_reactor.get()->submit(async_operation{
+            [&stmt, sql = std::string(sql)]() { return stmt.prepare_async(sql); },
+            [&stmt]() { return stmt.poll(); },
+            std::move(done)
+        });
+    }
+
+    void async_reactor::execute(statement& stmt, async_reactor::completion done) {
+        m_reactor.get()->submit(async_operation{
+            [&stmt]() { return stmt.execute_async(); },
+            [&stmt]() { return stmt.poll(); },
+            std::move(done)
+        });
+    }
+
+    void async_reactor::execute_direct(statement& stmt, std::string_view sql, async_reactor::completion done) {
+        m_reactor.get()->submit(async_operation{
+            [&stmt, sql = std::string(sql)]() { return stmt.execute_direct_async(sql); },
+            [&stmt]() { return stmt.poll(); },
+            std::move(done)
+        });
+    }
+
+    void async_reactor::next_record(statement& stmt, async_reactor::completion done) {
+        m_reactor.get()->submit(async_operation{
+            [&stmt]() { return stmt.next_record_async(); },
+            [&stmt]() { return stmt.poll(); },
+            std::move(done)
+        });
+    }
+
+    void async_reactor::connect(database_connection& dbc, std::string connection_string, async_reactor::completion done) {
+        m_reactor.get()->submit(async_operation{
+            [&dbc, connection_string = std::move(connection_string)]() { return dbc.connect_async(connection_string); },
+            [&dbc]() { return dbc.poll_connect(); },
+            std::move(done)
+        });
+    }
+
+    void async_reactor::watch(std::function<simql_types::async_status()> poll, async_reactor::completion done) {
+        std::function<simql_types::async_status()> start = poll;
+        m_reactor.get()->submit(async_operation{std::move(start), std::move(poll), std::move(done)});
+    }
+
+    std::size_t async_reactor::in_flight() {
+        return m_reactor.get()->in_flight.load(std::memory_order_relaxed);
+    }
+
+}
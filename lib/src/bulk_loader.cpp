@@ -0,0 +1,506 @@
+// SimQL stuff
+#include "bulk_loader.hpp"
+#include "environment.hpp"
+#include "database_connection.hpp"
+#include "statement.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <bit>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <format>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+    // advances past a quoted literal or identifier starting at 'i' and returns the index after it
+    std::size_t skip_quoted(std::string_view sql, std::size_t i) {
+        char open = sql[i];
+        char close = open == '[' ? ']' : open;
+        for (i++; i < sql.size(); i++) {
+            if (sql[i] == close) {
+
+                // doubled quotes are escapes
+                if (close != ']' && i + 1 < sql.size() && sql[i + 1] == close) {
+                    i++;
+                    continue;
+                }
+                return i + 1;
+            }
+        }
+        return sql.size();
+    }
+
+    bool is_quote(char c) {
+        return c == '\'' || c == '"' || c == '[';
+    }
+
+    bool is_word_char(char c) {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    std::size_t count_placeholders(std::string_view sql) {
+        std::size_t count{0};
+        for (std::size_t i = 0; i < sql.size();) {
+            if (is_quote(sql[i])) {
+                i = skip_quoted(sql, i);
+                continue;
+            }
+            if (sql[i] == '?')
+                count++;
+            i++;
+        }
+        return count;
+    }
+
+    // repeats the row of the VALUES clause so one statement inserts row_count rows
+    bool expand_values(std::string_view sql, std::size_t row_count, std::string& expanded) {
+        if (row_count == 0)
+            return false;
+
+        // find the VALUES keyword outside of quoted text
+        std::size_t values_at = std::string_view::npos;
+        for (std::size_t i = 0; i < sql.size();) {
+            if (is_quote(sql[i])) {
+                i = skip_quoted(sql, i);
+                continue;
+            }
+
+            if (i + 6 <= sql.size() && (i == 0 || !is_word_char(sql[i - 1])) && (i + 6 == sql.size() || !is_word_char(sql[i + 6]))) {
+                bool is_match{true};
+                for (std::size_t j = 0; j < 6 && is_match; j++)
+                    is_match = std::tolower(static_cast<unsigned char>(sql[i + j])) == "values"[j];
+
+                if (is_match) {
+                    values_at = i;
+                    break;
+                }
+            }
+            i++;
+        }
+        if (values_at == std::string_view::npos)
+            return false;
+
+        // the row template is the first parenthesized group after VALUES
+        std::size_t open = values_at + 6;
+        while (open < sql.size() && std::isspace(static_cast<unsigned char>(sql[open])))
+            open++;
+        if (open >= sql.size() || sql[open] != '(')
+            return false;
+
+        std::size_t close{open};
+        std::size_t depth{0};
+        for (std::size_t i = open; i < sql.size();) {
+            if (is_quote(sql[i])) {
+                i = skip_quoted(sql, i);
+                continue;
+            }
+            if (sql[i] == '(') {
+                depth++;
+            } else if (sql[i] == ')' && --depth == 0) {
+                close = i;
+                break;
+            }
+            i++;
+        }
+        if (depth != 0)
+            return false;
+
+        std::string_view row_template = sql.substr(open, close - open + 1);
+        expanded.clear();
+        expanded.reserve(sql.size() + (row_template.size() + 2) * (row_count - 1));
+        expanded.append(sql.substr(0, close + 1));
+        for (std::size_t r = 1; r < row_count; r++) {
+            expanded.append(", ");
+            expanded.append(row_template);
+        }
+        expanded.append(sql.substr(close + 1));
+        return true;
+    }
+
+}
+
+namespace simql {
+
+    struct bulk_loader::loader {
+
+        // a statement prepared for a fixed number of rows in multi-row VALUES mode
+        struct values_statement {
+            statement stmt;
+            std::vector<statement::sql_parameter_column> layout;
+            std::vector<statement::sql_row> rows;
+            values_statement(database_connection& dbc, const statement::alloc_options& options) : stmt(dbc, options), rows(1) {}
+        };
+
+        // each worker owns its connection and its prepared statements
+        struct worker {
+            database_connection dbc;
+            std::optional<statement> stmt;
+            std::map<std::size_t, std::unique_ptr<values_statement>> values_statements;
+            std::thread thread;
+            worker(environment& env, database_connection::alloc_options& options) : dbc(env, options) {}
+        };
+
+        // configuration
+        bulk_loader::alloc_options opts;
+        std::vector<statement::sql_parameter_column> layout;
+        std::string sql;
+        statement::alloc_options stmt_opts;
+        std::size_t rows_per_statement{1};
+
+        // shared row queue
+        std::mutex mtx;
+        std::condition_variable cvar_not_empty;
+        std::condition_variable cvar_not_full;
+        std::deque<statement::sql_row> rows;
+        bool is_finishing{false};
+
+        // workers
+        std::vector<std::unique_ptr<worker>> workers;
+        std::atomic<std::uint32_t> active_workers{0};
+
+        // counters
+        std::atomic<std::uint64_t> rows_pushed{0};
+        std::atomic<std::uint64_t> rows_committed{0};
+        std::atomic<std::uint64_t> rows_failed{0};
+        std::atomic<std::uint64_t> bytes_committed{0};
+        std::atomic<std::uint64_t> batches_executed{0};
+        std::atomic<std::uint64_t> commits{0};
+        std::chrono::steady_clock::time_point started{std::chrono::steady_clock::now()};
+        std::atomic<std::chrono::steady_clock::rep> finished{0};
+
+        // diagnostics
+        std::mutex error_mtx;
+        std::string last_error{};
+        bool is_valid{true};
+
+        loader(environment& env, const database_connection::alloc_options& dbc_options, std::string_view connection_string, std::string_view sql, std::vector<statement::sql_parameter_column> parameter_layout, const bulk_loader::alloc_options& loader_options, const statement::alloc_options& stmt_options) : opts(loader_options), layout(std::move(parameter_layout)), sql(sql), stmt_opts(stmt_options) {
+
+            if (opts.connection_count == 0)
+                opts.connection_count = 1;
+
+            if (opts.batch_rows == 0)
+                opts.batch_rows = 1;
+
+            if (opts.commit_interval == 0)
+                opts.commit_interval = 1;
+
+            // the expanded statement has to stay under the driver's parameter limit
+            if (opts.mode == bulk_loader::batch_mode::multi_row_values) {
+                std::string probe;
+                if (layout.empty() || !expand_values(sql, 1, probe) || count_placeholders(sql) != layout.size()) {
+                    set_error(std::string{"multi-row VALUES mode needs a single-row INSERT ... VALUES (?, ...) with one placeholder per layout column"});
+                    is_valid = false;
+                    return;
+                }
+
+                std::size_t max_rows = opts.max_statement_parameters > 0 ? std::max<std::size_t>(1, opts.max_statement_parameters / layout.size()) : opts.batch_rows;
+                rows_per_statement = std::min<std::size_t>(opts.batch_rows, max_rows);
+            }
+
+            // batches are committed explicitly
+            database_connection::alloc_options worker_dbc_options = dbc_options;
+            worker_dbc_options.enable_autocommit = false;
+
+            for (std::uint8_t i = 0; i < opts.connection_count; i++) {
+                auto w = std::make_unique<worker>(env, worker_dbc_options);
+                if (!w->dbc.is_valid() || !w->dbc.connect(std::string(connection_string))) {
+                    set_error(std::format("could not open loader connection::{} -> {}", i, w->dbc.last_error()));
+                    continue;
+                }
+
+                w->stmt.emplace(w->dbc, stmt_options);
+                if (!w->stmt->is_valid() || !w->stmt->prepare(sql)) {
+                    set_error(std::format("could not prepare loader statement::{} -> {}", i, w->stmt->last_error()));
+                    continue;
+                }
+
+                workers.push_back(std::move(w));
+            }
+
+            if (workers.empty()) {
+                is_valid = false;
+                return;
+            }
+
+            active_workers = static_cast<std::uint32_t>(workers.size());
+            for (auto& w : workers)
+                w->thread = std::thread([this, p_worker = w.get()]() { run(*p_worker); });
+        }
+
+        ~loader() {
+            finish();
+        }
+
+        void set_error(std::string message) {
+            std::lock_guard<std::mutex> lock(error_mtx);
+            last_error = std::move(message);
+        }
+
+        values_statement* get_values_statement(worker& w, std::size_t row_count) {
+            auto it = w.values_statements.find(row_count);
+            if (it != w.values_statements.end())
+                return it->second.get();
+
+            std::string expanded;
+            if (!expand_values(sql, row_count, expanded)) {
+                set_error(std::string{"could not expand the VALUES clause"});
+                return nullptr;
+            }
+
+            auto vs = std::make_unique<values_statement>(w.dbc, stmt_opts);
+            if (!vs->stmt.is_valid() || !vs->stmt.prepare(expanded)) {
+                set_error(std::format("could not prepare the {} row VALUES statement -> {}", row_count, vs->stmt.last_error()));
+                return nullptr;
+            }
+
+            vs->layout.reserve(row_count * layout.size());
+            for (std::size_t r = 0; r < row_count; r++)
+                vs->layout.insert(vs->layout.end(), layout.begin(), layout.end());
+
+            return w.values_statements.emplace(row_count, std::move(vs)).first->second.get();
+        }
+
+        // splits the batch into the full statement size and power-of-two tails so only a handful of sizes are ever prepared
+        bool execute_values(worker& w, std::vector<statement::sql_row>& batch) {
+            std::size_t offset{0};
+            while (offset < batch.size()) {
+                std::size_t remaining = batch.size() - offset;
+                std::size_t row_count = remaining >= rows_per_statement ? rows_per_statement : std::bit_floor(remaining);
+
+                // a single row is the statement as written
+                if (row_count == 1) {
+                    std::vector<statement::sql_row> single(1);
+                    single[0] = std::move(batch[offset]);
+                    if (!w.stmt->execute_batch(layout, single)) {
+                        set_error(std::format("could not execute the loaded batch -> {}", w.stmt->last_error()));
+                        return false;
+                    }
+                    offset++;
+                    continue;
+                }
+
+                values_statement* vs = get_values_statement(w, row_count);
+                if (!vs)
+                    return false;
+
+                statement::sql_row& merged = vs->rows[0];
+                merged.clear();
+                merged.reserve(row_count * layout.size());
+                for (std::size_t r = offset; r < offset + row_count; r++) {
+                    for (simql_types::sql_value& value : batch[r])
+                        merged.push_back(std::move(value));
+                }
+
+                if (!vs->stmt.execute_batch(vs->layout, vs->rows)) {
+                    set_error(std::format("could not execute the loaded batch -> {}", vs->stmt.last_error()));
+                    return false;
+                }
+                offset += row_count;
+            }
+            return true;
+        }
+
+        static std::uint64_t row_bytes(const statement::sql_row& row) {
+            std::uint64_t bytes{0};
+            for (const simql_types::sql_value& value : row)
+                bytes += value.byte_size();
+            return bytes;
+        }
+
+        bool push(statement::sql_row row) {
+            if (!is_valid)
+                return false;
+
+            std::unique_lock<std::mutex> lock(mtx);
+            if (opts.queue_capacity > 0)
+                cvar_not_full.wait(lock, [&]() { return rows.size() < opts.queue_capacity || is_finishing || active_workers == 0; });
+
+            if (is_finishing || active_workers == 0)
+                return false;
+
+            rows.push_back(std::move(row));
+            lock.unlock();
+
+            rows_pushed.fetch_add(1, std::memory_order_relaxed);
+            cvar_not_empty.notify_one();
+            return true;
+        }
+
+        void finish() {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (is_finishing)
+                    return;
+                is_finishing = true;
+            }
+            cvar_not_empty.notify_all();
+            cvar_not_full.notify_all();
+
+            for (auto& w : workers) {
+                if (w->thread.joinable())
+                    w->thread.join();
+            }
+            finished = (std::chrono::steady_clock::now() - started).count();
+        }
+
+        void run(worker& w) {
+            std::vector<statement::sql_row> batch;
+            batch.reserve(opts.batch_rows);
+            std::uint64_t batch_bytes{0};
+            std::chrono::steady_clock::time_point batch_deadline{};
+
+            std::uint32_t uncommitted_batches{0};
+            std::uint64_t uncommitted_rows{0};
+            std::uint64_t uncommitted_bytes{0};
+
+            auto commit = [&]() {
+                if (uncommitted_batches == 0)
+                    return;
+
+                if (w.dbc.commit()) {
+                    rows_committed.fetch_add(uncommitted_rows, std::memory_order_relaxed);
+                    bytes_committed.fetch_add(uncommitted_bytes, std::memory_order_relaxed);
+                    commits.fetch_add(1, std::memory_order_relaxed);
+                } else {
+                    set_error(std::format("could not commit the loaded batches -> {}", w.dbc.last_error()));
+                    w.dbc.rollback();
+                    rows_failed.fetch_add(uncommitted_rows, std::memory_order_relaxed);
+                }
+                uncommitted_batches = 0;
+                uncommitted_rows = 0;
+                uncommitted_bytes = 0;
+            };
+
+            auto flush = [&]() {
+                if (batch.empty())
+                    return;
+
+                batches_executed.fetch_add(1, std::memory_order_relaxed);
+                bool is_executed{false};
+                if (opts.mode == bulk_loader::batch_mode::multi_row_values) {
+                    is_executed = execute_values(w, batch);
+                } else {
+                    is_executed = w.stmt->execute_batch(layout, batch);
+                    if (!is_executed)
+                        set_error(std::format("could not execute the loaded batch -> {}", w.stmt->last_error()));
+                }
+
+                if (is_executed) {
+                    uncommitted_batches++;
+                    uncommitted_rows += batch.size();
+                    uncommitted_bytes += batch_bytes;
+                    if (uncommitted_batches >= opts.commit_interval)
+                        commit();
+                } else {
+
+                    // the failed batch takes the uncommitted batches of this transaction with it
+                    w.dbc.rollback();
+                    rows_failed.fetch_add(uncommitted_rows + batch.size(), std::memory_order_relaxed);
+                    uncommitted_batches = 0;
+                    uncommitted_rows = 0;
+                    uncommitted_bytes = 0;
+                }
+                batch.clear();
+                batch_bytes = 0;
+            };
+
+            while (true) {
+                bool is_drained{false};
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    auto has_work = [&]() { return !rows.empty() || is_finishing; };
+                    if (batch.empty())
+                        cvar_not_empty.wait(lock, has_work);
+                    else
+                        cvar_not_empty.wait_until(lock, batch_deadline, has_work);
+
+                    // take as many rows as the batch can hold under a single lock
+                    std::size_t taken{0};
+                    while (!rows.empty() && batch.size() < opts.batch_rows && (opts.batch_bytes == 0 || batch_bytes < opts.batch_bytes)) {
+                        if (batch.empty())
+                            batch_deadline = std::chrono::steady_clock::now() + opts.batch_interval;
+
+                        batch_bytes += row_bytes(rows.front());
+                        batch.push_back(std::move(rows.front()));
+                        rows.pop_front();
+                        taken++;
+                    }
+                    is_drained = is_finishing && rows.empty();
+
+                    if (taken > 0) {
+                        lock.unlock();
+                        cvar_not_full.notify_all();
+                    }
+                }
+
+                bool is_full = batch.size() >= opts.batch_rows || (opts.batch_bytes > 0 && batch_bytes >= opts.batch_bytes);
+                bool is_due = !batch.empty() && std::chrono::steady_clock::now() >= batch_deadline;
+                if (is_full || is_due || is_drained)
+                    flush();
+
+                if (is_drained && batch.empty()) {
+                    commit();
+                    break;
+                }
+            }
+
+            if (--active_workers == 0)
+                cvar_not_full.notify_all();
+        }
+
+        bulk_loader::statistics stats() {
+            bulk_loader::statistics s;
+            s.rows_pushed = rows_pushed.load(std::memory_order_relaxed);
+            s.rows_committed = rows_committed.load(std::memory_order_relaxed);
+            s.rows_failed = rows_failed.load(std::memory_order_relaxed);
+            s.bytes_committed = bytes_committed.load(std::memory_order_relaxed);
+            s.batches_executed = batches_executed.load(std::memory_order_relaxed);
+            s.commits = commits.load(std::memory_order_relaxed);
+
+            auto finished_at = finished.load();
+            s.elapsed = finished_at > 0 ? std::chrono::steady_clock::duration(finished_at) : std::chrono::steady_clock::now() - started;
+            return s;
+        }
+
+    };
+
+    bulk_loader::bulk_loader(environment& env, const database_connection::alloc_options& dbc_options, std::string_view connection_string, std::string_view sql, std::vector<statement::sql_parameter_column> layout, const bulk_loader::alloc_options& loader_options, const statement::alloc_options& stmt_options) : m_loader(std::make_unique<loader>(env, dbc_options, connection_string, sql, std::move(layout), loader_options, stmt_options)) {}
+    bulk_loader::~bulk_loader() = default;
+
+    bool bulk_loader::push(statement::sql_row row) {
+        return !m_loader ? false : m_loader->push(std::move(row));
+    }
+
+    void bulk_loader::finish() {
+        if (m_loader)
+            m_loader->finish();
+    }
+
+    bulk_loader::statistics bulk_loader::stats() {
+        return !m_loader ? bulk_loader::statistics{} : m_loader->stats();
+    }
+
+    bool bulk_loader::is_valid() {
+        return !m_loader ? false : m_loader->is_valid;
+    }
+
+    std::string bulk_loader::last_error() {
+        if (!m_loader)
+            return std::string{};
+
+        std::lock_guard<std::mutex> lock(m_loader->error_mtx);
+        return m_loader->last_error;
+    }
+
+}
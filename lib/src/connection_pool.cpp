@@ -0,0 +1,683 @@
+// SimQL stuff
+#include "connection_pool.hpp"
+#include "environment.hpp"
+#include "database_connection.hpp"
+#include "statement.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <deque>
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <utility>
+
+namespace simql {
+
+    extern std::vector<std::pair<std::string, std::shared_ptr<void>>> drain_cached_statements(database_connection& dbc);
+    extern bool restore_cached_statement(database_connection& dbc, const statement::alloc_options& options, std::string_view sql, std::shared_ptr<void> plan);
+
+    // what a dead connection had cached, a binding plan can only be bound to one new handle
+    struct restorable_statement {
+        std::string sql;
+        std::shared_ptr<void> plan;
+    };
+
+    struct pooled_connection {
+        std::unique_ptr<database_connection> connection;
+        std::chrono::steady_clock::time_point last_used{};
+    };
+
+    struct connection_pool::pool {
+        environment& env;
+        std::string connection_string;
+        connection_pool::alloc_options pool_opts;
+        database_connection::alloc_options conn_opts;
+
+        // idle connections with the most recently returned at the back, total also counts leased
+        // connections and those being opened so max_size holds while connecting is unlocked
+        std::mutex mtx;
+        std::deque<pooled_connection> idle;
+        std::size_t total{0};
+        connection_pool::pool_stats counters{};
+
+        // an acquire that finds nothing idle queues here, returned and newly opened connections go to the queue head
+        // directly so a later acquire cannot overtake it, a blocking acquire sleeps on its cvar while a coroutine
+        // polls served, everything is guarded by mtx
+        struct waiter {
+            std::condition_variable cvar;
+            std::unique_ptr<database_connection> handed{};
+            bool served{false};
+        };
+        std::deque<std::shared_ptr<waiter>> waiters;
+
+        // background maintenance, requested counts connections to open in place of dead ones, each queued waiter
+        // is owed a connection as well while the pool is below max_size
+        std::thread maintenance;
+        std::condition_variable maintenance_cvar;
+        std::size_t requested{0};
+        bool stopping{false};
+
+        // set by a failed open, acquire fails fast and opens wait for retry_at until one succeeds
+        bool down{false};
+        std::chrono::milliseconds backoff{0};
+        std::chrono::steady_clock::time_point retry_at{};
+        std::minstd_rand jitter{std::random_device{}()};
+
+        // statements to prepare again on the connections that replace dead ones
+        std::deque<restorable_statement> lost_statements;
+        std::atomic<std::uint64_t> restored_statements{0};
+
+        pool(environment& environment, std::string conn_string, const connection_pool::alloc_options& pool_options, const database_connection::alloc_options& conn_options) : env(environment), connection_string(std::move(conn_string)), pool_opts(pool_options), conn_opts(conn_options) {
+            if (pool_opts.max_size == 0 || pool_opts.max_size > simql_constants::limits::max_connection_pool_size)
+                pool_opts.max_size = simql_constants::limits::max_connection_pool_size;
+
+            if (pool_opts.min_size > pool_opts.max_size)
+                pool_opts.min_size = pool_opts.max_size;
+
+            if (pool_opts.reconnect_min_backoff.count() <= 0)
+                pool_opts.reconnect_min_backoff = std::chrono::milliseconds(1);
+
+            if (pool_opts.reconnect_max_backoff < pool_opts.reconnect_min_backoff)
+                pool_opts.reconnect_max_backoff = pool_opts.reconnect_min_backoff;
+
+            if (pool_opts.maintenance_interval.count() > 0)
+                maintenance = std::thread([this]() { maintain(); });
+        }
+
+        ~pool() {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+            }
+            maintenance_cvar.notify_all();
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                wake_waiters();
+            }
+            if (maintenance.joinable())
+                maintenance.join();
+
+            idle.clear();
+        }
+
+        // connecting is the slow part so it never runs under the lock
+        std::unique_ptr<database_connection> open(connection_pool::connection_timing* timing = nullptr) {
+            auto begin = std::chrono::steady_clock::now();
+            database_connection::alloc_options options = conn_opts;
+            auto conn = std::make_unique<database_connection>(env, options);
+            bool connected = conn->is_valid() && conn->connect(connection_string);
+            auto connected_at = std::chrono::steady_clock::now();
+
+            if (timing) {
+                timing->connected = connected;
+                timing->connect = std::chrono::duration_cast<std::chrono::microseconds>(connected_at - begin);
+                if (!connected)
+                    timing->error = std::string(conn->last_error());
+            }
+            if (!connected)
+                return nullptr;
+
+            restore_statements(*conn);
+            std::size_t prepared = prepare_statements(*conn);
+            if (timing) {
+                timing->prepare = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - connected_at);
+                timing->prepared = prepared;
+            }
+            return conn;
+        }
+
+        // a statement destroyed with its SQL prepared parks the handle in the connection's cache
+        std::size_t prepare_statements(database_connection& conn) {
+            if (pool_opts.prepared_statements.empty() || conn.statement_cache().capacity == 0)
+                return 0;
+
+            for (const std::string& sql : pool_opts.prepared_statements) {
+                statement stmt(conn, pool_opts.statement_options);
+                if (stmt.is_valid())
+                    stmt.prepare(sql);
+            }
+            return conn.statement_cache().size;
+        }
+
+        // one entry per distinct SQL, the remaining entries wait for the next replacement
+        std::vector<restorable_statement> take_lost_statements() {
+            std::vector<restorable_statement> taken;
+            std::lock_guard<std::mutex> lock(mtx);
+            for (auto it = lost_statements.begin(); it != lost_statements.end() && taken.size() < conn_opts.statement_cache_capacity;) {
+                if (std::any_of(taken.begin(), taken.end(), [&it](const restorable_statement& t) { return t.sql == it->sql; })) {
+                    ++it;
+                    continue;
+                }
+
+                taken.push_back(std::move(*it));
+                it = lost_statements.erase(it);
+            }
+            return taken;
+        }
+
+        // the least recently used go first so the most recently used end up at the front of the new cache
+        void restore_statements(database_connection& conn) {
+            if (!pool_opts.restore_statements || conn_opts.statement_cache_capacity == 0)
+                return;
+
+            std::vector<restorable_statement> restoring = take_lost_statements();
+            for (auto it = restoring.rbegin(); it != restoring.rend(); ++it) {
+                if (restore_cached_statement(conn, pool_opts.statement_options, it->sql, std::move(it->plan)))
+                    restored_statements.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        // dead connections give up their cached statements before they are destroyed, without the lock held
+        void retire(std::vector<std::unique_ptr<database_connection>>& dead) {
+            if (pool_opts.restore_statements && conn_opts.statement_cache_capacity > 0) {
+                std::size_t limit = conn_opts.statement_cache_capacity * pool_opts.max_size;
+                for (std::unique_ptr<database_connection>& conn : dead) {
+                    std::vector<std::pair<std::string, std::shared_ptr<void>>> drained = drain_cached_statements(*conn);
+                    std::lock_guard<std::mutex> lock(mtx);
+                    for (auto& [sql, plan] : drained)
+                        lost_statements.push_back(restorable_statement{std::move(sql), std::move(plan)});
+                    while (lost_statements.size() > limit)
+                        lost_statements.pop_front();
+                }
+            }
+            dead.clear();
+        }
+
+        // requires mtx, a failed open puts the pool down until a retry after a doubling, jittered backoff succeeds
+        void record_open(bool ok) {
+            if (ok) {
+                counters.opened++;
+                down = false;
+                backoff = std::chrono::milliseconds(0);
+                return;
+            }
+
+            counters.failed_opens++;
+            if (backoff.count() == 0)
+                backoff = pool_opts.reconnect_min_backoff;
+            else
+                backoff = std::min(backoff * 2, pool_opts.reconnect_max_backoff);
+
+            std::chrono::milliseconds half = backoff / 2;
+            std::uniform_int_distribution<std::int64_t> spread(0, half.count());
+            retry_at = std::chrono::steady_clock::now() + half + std::chrono::milliseconds(spread(jitter));
+            down = true;
+
+            // keeps the maintenance thread retrying until the server is back
+            requested = std::max<std::size_t>(requested, 1);
+
+            // waiters give up now rather than at their deadline
+            wake_waiters();
+        }
+
+        // requires mtx, a waiter checks stopping and down when it wakes
+        void wake_waiters() {
+            for (std::shared_ptr<waiter>& w : waiters)
+                w->cvar.notify_one();
+        }
+
+        // requires mtx, hands the connection to the longest waiting acquire or parks it as idle
+        void put_back(std::unique_ptr<database_connection> conn, std::chrono::steady_clock::time_point now) {
+            if (waiters.empty()) {
+                idle.push_back(pooled_connection{std::move(conn), now});
+                return;
+            }
+
+            std::shared_ptr<waiter> w = std::move(waiters.front());
+            waiters.pop_front();
+            w->handed = std::move(conn);
+            w->served = true;
+            w->cvar.notify_one();
+        }
+
+        // requires mtx, a waiter that was not served leaves the queue and takes one more look at the idle connections
+        std::unique_ptr<database_connection> leave(const std::shared_ptr<waiter>& w, std::vector<std::unique_ptr<database_connection>>& dead) {
+            if (w->served)
+                return std::move(w->handed);
+
+            std::erase(waiters, w);
+            return stopping ? nullptr : take_idle(dead);
+        }
+
+        // requires mtx
+        bool may_open() const {
+            return !down || std::chrono::steady_clock::now() >= retry_at;
+        }
+
+        // requires mtx, reserves a slot before unlocking to connect and gives it back if that fails
+        bool open_into_idle(std::unique_lock<std::mutex>& lock) {
+            total++;
+            lock.unlock();
+            std::unique_ptr<database_connection> conn = open();
+            lock.lock();
+
+            record_open(conn != nullptr);
+            if (!conn) {
+                total--;
+                return false;
+            }
+
+            put_back(std::move(conn), std::chrono::steady_clock::now());
+            return true;
+        }
+
+        connection_pool::warm_up_report warm_up(std::uint32_t count, std::uint32_t parallelism) {
+            auto begin = std::chrono::steady_clock::now();
+            connection_pool::warm_up_report report;
+
+            // the slots are reserved up front so acquire and maintenance respect max_size meanwhile
+            std::size_t wanted{0};
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                std::size_t target = std::min<std::size_t>(count, pool_opts.max_size);
+                wanted = (target > total && !stopping) ? target - total : 0;
+                total += wanted;
+            }
+            if (wanted == 0)
+                return report;
+
+            report.connections.resize(wanted);
+            std::vector<std::unique_ptr<database_connection>> opened(wanted);
+
+            std::size_t thread_count = parallelism == 0 ? wanted : parallelism;
+            thread_count = std::min<std::size_t>({thread_count, wanted, simql_constants::limits::max_connection_warm_up_threads});
+
+            // the calling thread opens connections as well
+            std::atomic<std::size_t> next{0};
+            auto work = [&]() {
+                for (std::size_t i = next.fetch_add(1); i < wanted; i = next.fetch_add(1))
+                    opened[i] = open(&report.connections[i]);
+            };
+
+            std::vector<std::thread> workers;
+            workers.reserve(thread_count - 1);
+            for (std::size_t i = 1; i < thread_count; i++)
+                workers.emplace_back(work);
+            work();
+            for (std::thread& worker : workers)
+                worker.join();
+
+            std::lock_guard<std::mutex> lock(mtx);
+            auto now = std::chrono::steady_clock::now();
+            for (std::unique_ptr<database_connection>& conn : opened) {
+                if (!conn) {
+                    total--;
+                    counters.failed_opens++;
+                    report.failed++;
+                    continue;
+                }
+
+                counters.opened++;
+                report.opened++;
+                put_back(std::move(conn), now);
+            }
+
+            report.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(now - begin);
+            return report;
+        }
+
+        // requires mtx, SQL_ATTR_CONNECTION_DEAD is answered from the driver's own state, no round trip to the server
+        std::unique_ptr<database_connection> take_idle(std::vector<std::unique_ptr<database_connection>>& dead) {
+            while (!idle.empty()) {
+                pooled_connection pc = std::move(idle.back());
+                idle.pop_back();
+                if (!pool_opts.validate_on_acquire || pc.connection->is_connected())
+                    return std::move(pc.connection);
+
+                dead.push_back(std::move(pc.connection));
+                total--;
+                counters.dead_replaced++;
+                requested++;
+            }
+            return nullptr;
+        }
+
+        std::unique_ptr<database_connection> acquire(std::chrono::steady_clock::time_point deadline) {
+            std::vector<std::unique_ptr<database_connection>> dead;
+            std::unique_lock<std::mutex> lock(mtx);
+
+            // without a maintenance thread or time to wait the connection has to be opened here
+            bool waiting = maintenance.joinable() && std::chrono::steady_clock::now() < deadline;
+
+            std::unique_ptr<database_connection> conn;
+            if (!stopping) {
+                conn = take_idle(dead);
+                if (!dead.empty())
+                    maintenance_cvar.notify_one();
+
+                // while the server is unreachable nobody waits, reconnecting is left to the maintenance thread
+                if (!conn && !waiting && may_open() && total + requested < pool_opts.max_size) {
+                    total++;
+                    lock.unlock();
+                    conn = open();
+                    lock.lock();
+                    record_open(conn != nullptr);
+                    if (!conn)
+                        total--;
+                } else if (!conn && waiting && !down) {
+                    auto w = std::make_shared<waiter>();
+                    waiters.push_back(w);
+                    maintenance_cvar.notify_one();
+                    w->cvar.wait_until(lock, deadline, [this, &w]() { return w->served || stopping || down; });
+                    conn = leave(w, dead);
+                }
+            }
+
+            lock.unlock();
+            retire(dead);
+            return conn;
+        }
+
+        // a coroutine's acquire joins the same queue but polls for its turn instead of sleeping, it never connects
+        // on the polling thread, without a maintenance thread it is served by released connections only
+        simql_types::async_status poll_acquire(std::shared_ptr<waiter>& w, std::chrono::steady_clock::time_point deadline, std::unique_ptr<database_connection>& conn) {
+            std::vector<std::unique_ptr<database_connection>> dead;
+            std::unique_lock<std::mutex> lock(mtx);
+
+            simql_types::async_status status{simql_types::async_status::pending};
+            bool expired = std::chrono::steady_clock::now() >= deadline;
+            if (!w) {
+                if (!stopping)
+                    conn = take_idle(dead);
+                if (!dead.empty())
+                    maintenance_cvar.notify_one();
+
+                if (conn) {
+                    status = simql_types::async_status::complete;
+                } else if (stopping || down || expired) {
+                    status = simql_types::async_status::failed;
+                } else {
+                    w = std::make_shared<waiter>();
+                    waiters.push_back(w);
+                    maintenance_cvar.notify_one();
+                }
+            } else if (w->served || stopping || down || expired) {
+                conn = leave(w, dead);
+                w.reset();
+                status = conn ? simql_types::async_status::complete : simql_types::async_status::failed;
+            }
+
+            lock.unlock();
+            retire(dead);
+            return status;
+        }
+
+        // a coroutine that stops waiting gives up its place, a connection handed to it meanwhile goes back
+        void cancel_acquire(std::shared_ptr<waiter>& w) {
+            if (!w)
+                return;
+
+            std::unique_ptr<database_connection> conn;
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (w->served)
+                    conn = std::move(w->handed);
+                else
+                    std::erase(waiters, w);
+            }
+            w.reset();
+            release(std::move(conn));
+        }
+
+        // never waits on the pool and never connects, the connection asked of the maintenance thread is picked up
+        // by a later call, without a maintenance thread only idle connections are handed out
+        std::unique_ptr<database_connection> try_acquire(bool ask_for_one) {
+            std::vector<std::unique_ptr<database_connection>> dead;
+            std::unique_lock<std::mutex> lock(mtx);
+
+            std::unique_ptr<database_connection> conn;
+            if (!stopping) {
+                conn = take_idle(dead);
+                if (!dead.empty())
+                    maintenance_cvar.notify_one();
+
+                if (!conn && ask_for_one && maintenance.joinable() && !down && total + requested < pool_opts.max_size) {
+                    requested++;
+                    maintenance_cvar.notify_one();
+                }
+            }
+
+            lock.unlock();
+            retire(dead);
+            return conn;
+        }
+
+        // a connection that cannot be reset or has died is dropped and replaced in the background
+        void release(std::unique_ptr<database_connection> conn) {
+            if (!conn)
+                return;
+
+            bool healthy = conn->reset_session() && conn->is_connected();
+
+            std::unique_lock<std::mutex> lock(mtx);
+            if (!healthy || stopping) {
+                total--;
+                if (!healthy && !stopping) {
+                    counters.dead_replaced++;
+                    requested++;
+                    maintenance_cvar.notify_one();
+                }
+                lock.unlock();
+                if (healthy) {
+                    conn.reset();
+                    return;
+                }
+
+                std::vector<std::unique_ptr<database_connection>> dead;
+                dead.push_back(std::move(conn));
+                retire(dead);
+                return;
+            }
+
+            put_back(std::move(conn), std::chrono::steady_clock::now());
+        }
+
+        connection_pool::pool_stats stats() {
+            std::lock_guard<std::mutex> lock(mtx);
+            connection_pool::pool_stats snapshot = counters;
+            snapshot.idle = idle.size();
+            snapshot.total = total;
+            snapshot.reconnecting = down;
+            snapshot.restored_statements = restored_statements.load(std::memory_order_relaxed);
+            return snapshot;
+        }
+
+        // --------------------------------------------------
+        // MAINTENANCE
+        // --------------------------------------------------
+
+        void maintain() {
+            std::unique_lock<std::mutex> lock(mtx);
+            while (!stopping) {
+                // a pool that is down sleeps until its next retry rather than on every request
+                if (down)
+                    maintenance_cvar.wait_until(lock, std::min(retry_at, std::chrono::steady_clock::now() + pool_opts.maintenance_interval), [this]() { return stopping; });
+                else
+                    maintenance_cvar.wait_for(lock, pool_opts.maintenance_interval, [this]() { return stopping || requested > 0 || owes_open(); });
+                if (stopping)
+                    break;
+
+                run_maintenance(lock);
+            }
+        }
+
+        // requires mtx, connections are destroyed and opened with the lock released
+        void run_maintenance(std::unique_lock<std::mutex>& lock) {
+            auto now = std::chrono::steady_clock::now();
+            std::vector<std::unique_ptr<database_connection>> dead;
+            std::vector<std::unique_ptr<database_connection>> trimmed;
+
+            // dead idle connections are replaced one for one
+            for (auto it = idle.begin(); it != idle.end();) {
+                if (it->connection->is_connected()) {
+                    ++it;
+                    continue;
+                }
+
+                dead.push_back(std::move(it->connection));
+                it = idle.erase(it);
+                total--;
+                counters.dead_replaced++;
+                requested++;
+            }
+
+            // the oldest idle connections sit at the front
+            if (pool_opts.idle_ttl.count() > 0) {
+                while (!idle.empty() && total > pool_opts.min_size && now - idle.front().last_used >= pool_opts.idle_ttl) {
+                    trimmed.push_back(std::move(idle.front().connection));
+                    idle.pop_front();
+                    total--;
+                    counters.trimmed++;
+                }
+            }
+
+            if (!dead.empty() || !trimmed.empty()) {
+                lock.unlock();
+                trimmed.clear();
+                retire(dead);
+                lock.lock();
+            }
+
+            // a failed open ends the round and backs off so a server that is down is not hammered
+            while (!stopping && requested > 0 && may_open()) {
+                requested--;
+                if (total >= pool_opts.max_size)
+                    continue;
+
+                if (!open_into_idle(lock))
+                    break;
+            }
+
+            while (!stopping && owes_open() && may_open()) {
+                if (!open_into_idle(lock))
+                    break;
+            }
+
+            while (!stopping && total < pool_opts.min_size && may_open()) {
+                if (!open_into_idle(lock))
+                    break;
+            }
+        }
+
+        // requires mtx, more acquires are queued than idle connections are there to serve them
+        bool owes_open() const {
+            return waiters.size() > idle.size() && total < pool_opts.max_size;
+        }
+    };
+
+    // --------------------------------------------------
+    // LEASE
+    // --------------------------------------------------
+
+    connection_pool::lease::lease(pool* owner, std::unique_ptr<database_connection> conn) : m_owner(owner), m_connection(std::move(conn)) {}
+
+    connection_pool::lease::~lease() {
+        give_back();
+    }
+
+    connection_pool::lease::lease(lease&& other) noexcept : m_owner(other.m_owner), m_connection(std::move(other.m_connection)) {
+        other.m_owner = nullptr;
+    }
+
+    connection_pool::lease& connection_pool::lease::operator=(lease&& other) noexcept {
+        if (this != &other) {
+            give_back();
+            m_owner = other.m_owner;
+            m_connection = std::move(other.m_connection);
+            other.m_owner = nullptr;
+        }
+        return *this;
+    }
+
+    bool connection_pool::lease::is_valid() const {
+        return m_connection != nullptr;
+    }
+
+    database_connection& connection_pool::lease::connection() {
+        return *m_connection;
+    }
+
+    database_connection* connection_pool::lease::operator->() {
+        return m_connection.get();
+    }
+
+    void connection_pool::lease::give_back() {
+        if (m_owner && m_connection)
+            m_owner->release(std::move(m_connection));
+
+        m_owner = nullptr;
+        m_connection.reset();
+    }
+
+    // --------------------------------------------------
+    // POOL
+    // --------------------------------------------------
+
+    connection_pool::connection_pool(environment& env, std::string connection_string, const connection_pool::alloc_options& pool_options, const database_connection::alloc_options& conn_options) : m_pool(std::make_unique<pool>(env, std::move(connection_string), pool_options, conn_options)) {
+        build_pool();
+    }
+
+    connection_pool::~connection_pool() = default;
+
+    void connection_pool::build_pool() {
+        m_pool.get()->warm_up(m_pool.get()->pool_opts.min_size, 0);
+    }
+
+    connection_pool::warm_up_report connection_pool::warm_up(std::uint32_t count, std::uint32_t parallelism) {
+        return m_pool.get()->warm_up(count, parallelism);
+    }
+
+    connection_pool::lease connection_pool::acquire() {
+        return acquire(std::chrono::steady_clock::now() + m_pool.get()->pool_opts.acquire_timeout);
+    }
+
+    connection_pool::lease connection_pool::acquire(std::chrono::steady_clock::time_point deadline) {
+        std::unique_ptr<database_connection> conn = m_pool.get()->acquire(deadline);
+        if (!conn)
+            return lease{};
+
+        return lease(m_pool.get(), std::move(conn));
+    }
+
+    simql_types::async_status connection_pool::poll_acquire(std::shared_ptr<void>& waiter, std::chrono::steady_clock::time_point deadline, lease& out) {
+        std::shared_ptr<pool::waiter> w = std::static_pointer_cast<pool::waiter>(waiter);
+        std::unique_ptr<database_connection> conn;
+        simql_types::async_status status = m_pool.get()->poll_acquire(w, deadline, conn);
+        waiter = std::move(w);
+        if (conn)
+            out = lease(m_pool.get(), std::move(conn));
+        return status;
+    }
+
+    void connection_pool::cancel_acquire(std::shared_ptr<void>& waiter) {
+        std::shared_ptr<pool::waiter> w = std::static_pointer_cast<pool::waiter>(waiter);
+        m_pool.get()->cancel_acquire(w);
+        waiter.reset();
+    }
+
+    connection_pool::lease connection_pool::try_acquire(bool ask_for_one) {
+        std::unique_ptr<database_connection> conn = m_pool.get()->try_acquire(ask_for_one);
+        if (!conn)
+            return lease{};
+
+        return lease(m_pool.get(), std::move(conn));
+    }
+
+    void connection_pool::release(lease&& conn) {
+        lease returned = std::move(conn);
+        returned.give_back();
+    }
+
+    connection_pool::pool_stats connection_pool::stats() {
+        return m_pool.get()->stats();
+    }
+
+}
@@ -3,6 +3,7 @@
 #include "environment.hpp"
 #include "simql_strings.hpp"
 #include "diagnostic_set.hpp"
+#include "simql_metrics.hpp"
 
 // STL stuff
 #include <cstdint>
@@ -10,6 +11,10 @@
 #include <vector>
 #include <string>
 #include <string_view>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <thread>
 
 // OS stuff
 #include "os_inclusions.hpp"
@@ -35,8 +40,32 @@ namespace simql {
 
         // trackers
         bool is_valid{true};
-
-        explicit handle(environment& env, database_connection::alloc_options& options) {
+        bool autocommit{true};
+
+        // prepared statement cache, the most recently used entry is at the front
+        struct cached_statement {
+            std::size_t key;
+            std::string sql;
+            SQLHSTMT h_stmt;
+            std::shared_ptr<void> plan;
+            simql_types::cursor_attributes cursor;
+        };
+        std::mutex cache_mutex;
+        std::list<cached_statement> cache_entries;
+        std::unordered_map<std::size_t, std::list<cached_statement>::iterator> cache_index;
+        std::size_t cache_capacity{0};
+        std::uint64_t cache_hits{0};
+        std::uint64_t cache_misses{0};
+        std::uint64_t cache_evictions{0};
+
+        // a connect still in flight, SQLDriverConnect has to be called again with the same buffers until it finishes
+        bool connect_pending{false};
+        bool async_enabled{false};
+        std::basic_string<SQLWCHAR> pending_connection_in{};
+        std::basic_string<SQLWCHAR> pending_connection_out{};
+        SQLSMALLINT pending_connection_out_length{0};
+
+        explicit handle(environment& env, database_connection::alloc_options& options) : cache_capacity(options.statement_cache_capacity) {
 
             // allocate the handle
             h_env = static_cast<SQLHENV>(get_env_handle(env));
@@ -79,6 +108,7 @@ namespace simql {
                 return;
 
             // set autocommit
+            autocommit = options.enable_autocommit;
             is_valid = set_autocommit(options.enable_autocommit);
             if (!is_valid)
                 return;
@@ -96,6 +126,15 @@ namespace simql {
         }
 
         ~handle() {
+
+            // a connect still in flight is cancelled rather than waited out, the polls then finish it off
+            if (connect_pending && async_enabled)
+                SQLCancelHandle(SQL_HANDLE_DBC, h_dbc);
+
+            while (poll_connect() == simql_types::async_status::pending)
+                std::this_thread::yield();
+
+            clear_cache();
             if (is_connected())
                 SQLDisconnect(h_dbc);
 
@@ -246,12 +285,16 @@ namespace simql {
         }
 
         bool connect(std::string connection_string) {
-            auto connection_string_in = simql_strings::to_odbc_w(std::string_view(reinterpret_cast<const char*>(connection_string.data()), connection_string.size()));
+            auto connection_string_in = simql_strings::to_odbc_w(std::string_view(connection_string));
             std::basic_string<SQLWCHAR> connection_string_out;
             connection_string_out.resize(1024);
             SQLSMALLINT connection_string_out_length{0};
             SQLSMALLINT buffer_length = connection_string_out.size();
-            switch (SQLDriverConnectW(h_dbc, nullptr, connection_string_in.data(), SQL_NTS, connection_string_out.data(), buffer_length, &connection_string_out_length, SQL_DRIVER_NOPROMPT)) {
+            return finish_connect(SQLDriverConnectW(h_dbc, nullptr, connection_string_in.data(), SQL_NTS, connection_string_out.data(), buffer_length, &connection_string_out_length, SQL_DRIVER_NOPROMPT));
+        }
+
+        bool finish_connect(SQLRETURN rc) {
+            switch (rc) {
             case SQL_SUCCESS:
                 return true;
             case SQL_SUCCESS_WITH_INFO:
@@ -268,6 +311,44 @@ namespace simql {
             }
         }
 
+        // SQL_ATTR_ASYNC_DBC_FUNCTIONS_ENABLE needs an environment set to odbc_version::odbc38 and a 3.8 driver, without them the connect runs
+        // synchronously in the first poll, either way the connection is synchronous again once it has finished
+        simql_types::async_status connect_async(std::string connection_string) {
+            if (connect_pending) {
+                last_error = std::string{"a connect is still pending on the connection"};
+                return simql_types::async_status::failed;
+            }
+
+            pending_connection_in = simql_strings::to_odbc_w(std::string_view(connection_string));
+            pending_connection_out.assign(1024, 0);
+            pending_connection_out_length = 0;
+            connect_pending = true;
+
+            SQLPOINTER p_async = reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(SQL_ASYNC_DBC_ENABLE_ON));
+            async_enabled = SQL_SUCCEEDED(SQLSetConnectAttrW(h_dbc, SQL_ATTR_ASYNC_DBC_FUNCTIONS_ENABLE, p_async, SQL_IS_UINTEGER));
+            return poll_connect();
+        }
+
+        simql_types::async_status poll_connect() {
+            if (!connect_pending)
+                return simql_types::async_status::complete;
+
+            SQLSMALLINT buffer_length = static_cast<SQLSMALLINT>(pending_connection_out.size());
+            SQLRETURN rc = SQLDriverConnectW(h_dbc, nullptr, pending_connection_in.data(), SQL_NTS, pending_connection_out.data(), buffer_length, &pending_connection_out_length, SQL_DRIVER_NOPROMPT);
+            if (rc == SQL_STILL_EXECUTING)
+                return simql_types::async_status::pending;
+
+            connect_pending = false;
+            pending_connection_in.clear();
+            pending_connection_out.clear();
+            if (async_enabled) {
+                SQLSetConnectAttrW(h_dbc, SQL_ATTR_ASYNC_DBC_FUNCTIONS_ENABLE, reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(SQL_ASYNC_DBC_ENABLE_OFF)), SQL_IS_UINTEGER);
+                async_enabled = false;
+            }
+
+            return finish_connect(rc) ? simql_types::async_status::complete : simql_types::async_status::failed;
+        }
+
         bool is_connected() {
             SQLUINTEGER output;
             switch (SQLGetConnectAttrW(h_dbc, SQL_ATTR_CONNECTION_DEAD, &output, SQL_IS_INTEGER, nullptr)) {
@@ -287,9 +368,121 @@ namespace simql {
         }
 
         void disconnect() {
+            clear_cache();
             if (is_connected())
                 SQLDisconnect(h_dbc);
         }
+
+        bool end_transaction(bool commit) {
+            switch (SQLEndTran(SQL_HANDLE_DBC, h_dbc, commit ? SQL_COMMIT : SQL_ROLLBACK)) {
+            case SQL_SUCCESS:
+                return true;
+            case SQL_SUCCESS_WITH_INFO:
+                diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::string{"SQLEndTran() -> SUCCESS_WITH_INFO"});
+                return true;
+            case SQL_INVALID_HANDLE:
+                last_error = commit ? std::string{"could not commit the transaction: invalid handle"} : std::string{"could not roll back the transaction: invalid handle"};
+                diag.update(h_env, diagnostic_set::handle_type::env, std::string{"SQLEndTran() -> INVALID_HANDLE"});
+                return false;
+            default:
+                last_error = commit ? std::string{"could not commit the transaction: generic error"} : std::string{"could not roll back the transaction: generic error"};
+                diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::string{"SQLEndTran() -> ERROR"});
+                return false;
+            }
+        }
+
+        // --------------------------------------------------
+        // PREPARED STATEMENT CACHE
+        // --------------------------------------------------
+
+        // the caller owns the returned handle until it is checked back in
+        bool checkout(std::size_t key, std::string_view sql, void*& stmt_handle, std::shared_ptr<void>& plan, simql_types::cursor_attributes& cursor) {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            if (cache_capacity == 0)
+                return false;
+
+            auto it = cache_index.find(key);
+            if (it == cache_index.end() || it->second->sql != sql) {
+                cache_misses++;
+                return false;
+            }
+
+            stmt_handle = reinterpret_cast<void*>(it->second->h_stmt);
+            plan = std::move(it->second->plan);
+            cursor = it->second->cursor;
+            cache_entries.erase(it->second);
+            cache_index.erase(it);
+            cache_hits++;
+            return true;
+        }
+
+        // returns false when the cache declines the handle, the caller then frees it
+        bool checkin(std::size_t key, std::string_view sql, void* stmt_handle, std::shared_ptr<void> plan, const simql_types::cursor_attributes& cursor) {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            if (cache_capacity == 0 || cache_index.contains(key))
+                return false;
+
+            cache_entries.push_front(cached_statement{key, std::string(sql), static_cast<SQLHSTMT>(stmt_handle), std::move(plan), cursor});
+            cache_index[key] = cache_entries.begin();
+            trim_cache(cache_capacity);
+            return true;
+        }
+
+        // the HSTMT is freed before its binding plan so the driver never sees released buffers
+        void trim_cache(std::size_t capacity) {
+            while (cache_entries.size() > capacity) {
+                cached_statement& entry = cache_entries.back();
+                SQLFreeHandle(SQL_HANDLE_STMT, entry.h_stmt);
+                simql_metrics::add(simql_metrics::counter::handles_freed);
+                cache_index.erase(entry.key);
+                cache_entries.pop_back();
+                cache_evictions++;
+            }
+        }
+
+        void clear_cache() {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            for (cached_statement& entry : cache_entries)
+                SQLFreeHandle(SQL_HANDLE_STMT, entry.h_stmt);
+            simql_metrics::add(simql_metrics::counter::handles_freed, cache_entries.size());
+
+            cache_entries.clear();
+            cache_index.clear();
+        }
+
+        // the binding plans outlive their freed HSTMTs so they can be bound again on another connection
+        std::vector<std::pair<std::string, std::shared_ptr<void>>> drain_cache() {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            std::vector<std::pair<std::string, std::shared_ptr<void>>> drained;
+            drained.reserve(cache_entries.size());
+            for (cached_statement& entry : cache_entries) {
+                SQLFreeHandle(SQL_HANDLE_STMT, entry.h_stmt);
+                drained.emplace_back(std::move(entry.sql), std::move(entry.plan));
+            }
+            simql_metrics::add(simql_metrics::counter::handles_freed, cache_entries.size());
+
+            cache_entries.clear();
+            cache_index.clear();
+            return drained;
+        }
+
+        void set_cache_capacity(std::size_t capacity) {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            cache_capacity = capacity;
+            trim_cache(capacity);
+        }
+
+        bool reset_session() {
+            if (autocommit)
+                return true;
+
+            return end_transaction(false);
+        }
+
+        database_connection::statement_cache_stats cache_stats() {
+            std::lock_guard<std::mutex> lock(cache_mutex);
+            return database_connection::statement_cache_stats{cache_hits, cache_misses, cache_evictions, cache_entries.size(), cache_capacity};
+        }
     };
 
     database_connection::database_connection(environment& env, database_connection::alloc_options& options) : p_handle(std::make_unique<handle>(env, options)) {}
@@ -301,6 +494,14 @@ namespace simql {
         return p_handle ? p_handle->connect(connection_string) : false;
     }
 
+    simql_types::async_status database_connection::connect_async(std::string connection_string) {
+        return p_handle ? p_handle->connect_async(connection_string) : simql_types::async_status::failed;
+    }
+
+    simql_types::async_status database_connection::poll_connect() {
+        return p_handle ? p_handle->poll_connect() : simql_types::async_status::failed;
+    }
+
     bool database_connection::is_connected() {
         return p_handle ? p_handle->is_connected() : false;
     }
@@ -310,6 +511,32 @@ namespace simql {
             p_handle->disconnect();
     }
 
+    bool database_connection::commit() {
+        return p_handle ? p_handle->end_transaction(true) : false;
+    }
+
+    bool database_connection::rollback() {
+        return p_handle ? p_handle->end_transaction(false) : false;
+    }
+
+    bool database_connection::reset_session() {
+        return p_handle ? p_handle->reset_session() : false;
+    }
+
+    database_connection::statement_cache_stats database_connection::statement_cache() {
+        return p_handle ? p_handle->cache_stats() : database_connection::statement_cache_stats{};
+    }
+
+    void database_connection::set_statement_cache_capacity(std::size_t capacity) {
+        if (p_handle)
+            p_handle->set_cache_capacity(capacity);
+    }
+
+    void database_connection::clear_statement_cache() {
+        if (p_handle)
+            p_handle->clear_cache();
+    }
+
     bool database_connection::is_valid() {
         return !p_handle ? false : p_handle->is_valid;
     }
@@ -326,4 +553,19 @@ namespace simql {
         return dbc.p_handle ? reinterpret_cast<void*>(dbc.p_handle->h_dbc) : nullptr;
     }
 
+    bool checkout_cached_statement(database_connection& dbc, std::size_t key, std::string_view sql, void*& stmt_handle, std::shared_ptr<void>& plan, simql_types::cursor_attributes& cursor) {
+        return dbc.p_handle ? dbc.p_handle->checkout(key, sql, stmt_handle, plan, cursor) : false;
+    }
+
+    bool checkin_cached_statement(database_connection& dbc, std::size_t key, std::string_view sql, void* stmt_handle, std::shared_ptr<void> plan, const simql_types::cursor_attributes& cursor) {
+        return dbc.p_handle ? dbc.p_handle->checkin(key, sql, stmt_handle, std::move(plan), cursor) : false;
+    }
+
+    std::vector<std::pair<std::string, std::shared_ptr<void>>> drain_cached_statements(database_connection& dbc) {
+        if (!dbc.p_handle)
+            return {};
+
+        return dbc.p_handle->drain_cache();
+    }
+
 }
\ No newline at end of file
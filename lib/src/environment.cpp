@@ -79,8 +79,8 @@ namespace simql {
                 p_odbc = reinterpret_cast<SQLPOINTER>(SQL_OV_ODBC3);
                 break;
             case environment::odbc_version::odbc38:
-                last_error = std::string{"ODBC version 3.8 is not available yet"};
-                return false;
+                p_odbc = reinterpret_cast<SQLPOINTER>(SQL_OV_ODBC3_80);
+                break;
             }
 
             switch (SQLSetEnvAttr(h_env, SQL_ATTR_ODBC_VERSION, p_odbc, SQL_IS_INTEGER)) {
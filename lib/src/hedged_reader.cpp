@@ -0,0 +1,408 @@
+// SimQL stuff
+#include "hedged_reader.hpp"
+#include "connection_pool.hpp"
+#include "statement.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <algorithm>
+#include <functional>
+
+namespace simql {
+
+    // binding is set while bind or execute may read the caller's parameters, running while execute may be
+    // interrupted, the statement then stays put until finished is set
+    struct hedge_attempt {
+        connection_pool* pool{nullptr};
+        connection_pool::lease conn{};
+        std::unique_ptr<statement> stmt{};
+        bool binding{false};
+        bool running{false};
+        bool finished{false};
+        std::string error{};
+    };
+
+    // attempt 0 runs on the calling thread, attempt 1 is the hedge
+    struct hedge_state {
+        std::mutex mtx;
+        std::condition_variable cvar;
+        std::array<hedge_attempt, 2> attempts{};
+        int winner{-1};
+        bool hedge_launched{false};
+        bool hedge_abandoned{false};
+        std::string sql{};
+        const hedged_reader::binder* bind{nullptr};
+    };
+
+    struct hedged_reader::reader {
+        std::vector<connection_pool*> pools;
+        hedged_reader::alloc_options opts;
+        std::atomic<std::size_t> next_pool{0};
+
+        // recent latencies of first attempts over the span the hedge timer covers, acquire and prepare included, an
+        // attempt that failed or was cancelled by a winning hedge leaves no sample, the hedge delay is refreshed from
+        // them every few samples
+        std::mutex samples_mtx;
+        std::vector<std::int64_t> samples;
+        std::uint64_t samples_seen{0};
+        std::atomic<std::int64_t> hedge_delay_ns{-1};
+
+        std::atomic<std::uint64_t> reads{0};
+        std::atomic<std::uint64_t> hedged{0};
+        std::atomic<std::uint64_t> hedge_wins{0};
+        std::atomic<std::uint64_t> skipped{0};
+
+        // pending hedges ordered by when they fire, launched hedges wait for a free worker
+        std::mutex mtx;
+        std::condition_variable timer_cvar;
+        std::condition_variable worker_cvar;
+        std::multimap<std::chrono::steady_clock::time_point, std::shared_ptr<hedge_state>> pending;
+        std::deque<std::shared_ptr<hedge_state>> launches;
+        std::uint32_t idle_workers{0};
+        std::thread timer;
+        std::vector<std::thread> workers;
+        bool stopping{false};
+
+        reader(const std::vector<std::reference_wrapper<connection_pool>>& connection_pools, const hedged_reader::alloc_options& options) : opts(options) {
+            pools.reserve(connection_pools.size());
+            for (connection_pool& pool : connection_pools)
+                pools.push_back(&pool);
+
+            opts.hedge_percentile = std::clamp(opts.hedge_percentile, 0.0, 1.0);
+            if (opts.sample_window == 0)
+                opts.sample_window = 1;
+            opts.min_samples = std::clamp(opts.min_samples, 1u, opts.sample_window);
+            samples.reserve(opts.sample_window);
+
+            if (pools.empty() || opts.max_hedges_in_flight == 0)
+                return;
+
+            idle_workers = opts.max_hedges_in_flight;
+            timer = std::thread([this]() { run_timer(); });
+            workers.reserve(opts.max_hedges_in_flight);
+            for (std::uint32_t i = 0; i < opts.max_hedges_in_flight; i++)
+                workers.emplace_back([this]() { run_worker(); });
+        }
+
+        ~reader() {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+            }
+            timer_cvar.notify_all();
+            worker_cvar.notify_all();
+            if (timer.joinable())
+                timer.join();
+
+            for (std::thread& worker : workers)
+                worker.join();
+        }
+
+        // --------------------------------------------------
+        // LATENCY
+        // --------------------------------------------------
+
+        void record(std::chrono::nanoseconds elapsed) {
+            std::lock_guard<std::mutex> lock(samples_mtx);
+            if (samples.size() < opts.sample_window)
+                samples.push_back(elapsed.count());
+            else
+                samples[samples_seen % opts.sample_window] = elapsed.count();
+            samples_seen++;
+
+            if (samples.size() < opts.min_samples || (samples_seen % 16 != 0 && hedge_delay_ns.load(std::memory_order_relaxed) >= 0))
+                return;
+
+            std::vector<std::int64_t> sorted = samples;
+            auto rank = sorted.begin() + static_cast<std::ptrdiff_t>(opts.hedge_percentile * static_cast<double>(sorted.size() - 1));
+            std::nth_element(sorted.begin(), rank, sorted.end());
+
+            std::int64_t floor = std::chrono::duration_cast<std::chrono::nanoseconds>(opts.min_delay).count();
+            hedge_delay_ns.store(std::max(*rank, floor), std::memory_order_relaxed);
+        }
+
+        // --------------------------------------------------
+        // ATTEMPTS
+        // --------------------------------------------------
+
+        // the first attempt to succeed wins and cancels the other if it is still executing
+        void finish(hedge_state& st, std::size_t index, bool ok, std::string error) {
+            std::lock_guard<std::mutex> lock(st.mtx);
+            hedge_attempt& attempt = st.attempts[index];
+            attempt.binding = false;
+            attempt.running = false;
+            attempt.finished = true;
+            attempt.error = std::move(error);
+
+            if (ok && st.winner < 0) {
+                st.winner = static_cast<int>(index);
+                hedge_attempt& other = st.attempts[1 - index];
+                if (other.running)
+                    other.stmt->cancel();
+            }
+
+            // a hedge is only worth starting while the first attempt is outstanding
+            if (index == 0)
+                st.hedge_abandoned = true;
+
+            st.cvar.notify_all();
+        }
+
+        // an attempt the other one has already beaten stops before its next step, binding marks it as reading
+        // the caller's parameters from here on
+        bool proceed(hedge_state& st, std::size_t index, bool binding) {
+            std::lock_guard<std::mutex> lock(st.mtx);
+            if (st.winner >= 0)
+                return false;
+
+            st.attempts[index].binding = binding;
+            return true;
+        }
+
+        // returns whether the attempt's execute succeeded
+        bool run_attempt(hedge_state& st, std::size_t index) {
+            hedge_attempt& attempt = st.attempts[index];
+            if (!proceed(st, index, false)) {
+                finish(st, index, false, std::string{"the other attempt already won"});
+                return false;
+            }
+
+            // declared ahead of the statement so the statement is freed before its connection goes back
+            connection_pool::lease conn = attempt.pool->acquire();
+            if (!conn.is_valid()) {
+                finish(st, index, false, std::string{"could not acquire a connection for the read"});
+                return false;
+            }
+
+            if (!proceed(st, index, false)) {
+                finish(st, index, false, std::string{"the other attempt already won"});
+                return false;
+            }
+
+            auto stmt = std::make_unique<statement>(conn.connection(), opts.statement_options);
+            if (!stmt->is_valid() || !stmt->prepare(st.sql)) {
+                finish(st, index, false, std::string(stmt->last_error()));
+                return false;
+            }
+
+            if (!proceed(st, index, true)) {
+                finish(st, index, false, std::string{"the other attempt already won"});
+                return false;
+            }
+
+            if (st.bind && *st.bind && !(*st.bind)(*stmt)) {
+                finish(st, index, false, std::string(stmt->last_error()));
+                return false;
+            }
+
+            statement* running{nullptr};
+            {
+                std::lock_guard<std::mutex> lock(st.mtx);
+                attempt.conn = std::move(conn);
+                attempt.stmt = std::move(stmt);
+                if (st.winner < 0) {
+                    attempt.running = true;
+                    running = attempt.stmt.get();
+                }
+            }
+
+            std::string error{};
+            bool ok{false};
+            if (running) {
+                ok = running->execute();
+                if (!ok)
+                    error = std::string(running->last_error());
+            } else {
+                error = std::string{"the other attempt already won"};
+            }
+
+            finish(st, index, ok, std::move(error));
+            return ok;
+        }
+
+        // --------------------------------------------------
+        // HEDGING
+        // --------------------------------------------------
+
+        void run_timer() {
+            std::unique_lock<std::mutex> lock(mtx);
+            while (!stopping) {
+                if (pending.empty()) {
+                    timer_cvar.wait(lock, [this]() { return stopping || !pending.empty(); });
+                    continue;
+                }
+
+                auto due = pending.begin()->first;
+                if (std::chrono::steady_clock::now() < due) {
+                    timer_cvar.wait_until(lock, due);
+                    continue;
+                }
+
+                std::shared_ptr<hedge_state> st = std::move(pending.begin()->second);
+                pending.erase(pending.begin());
+                launch(st);
+            }
+
+            for (auto& [due, st] : pending) {
+                std::lock_guard<std::mutex> st_lock(st->mtx);
+                st->hedge_abandoned = true;
+            }
+            pending.clear();
+        }
+
+        // requires mtx
+        void launch(const std::shared_ptr<hedge_state>& st) {
+            std::lock_guard<std::mutex> st_lock(st->mtx);
+            if (st->hedge_abandoned || st->attempts[0].finished)
+                return;
+
+            if (idle_workers == 0) {
+                st->hedge_abandoned = true;
+                skipped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+
+            idle_workers--;
+            st->hedge_launched = true;
+            launches.push_back(st);
+            hedged.fetch_add(1, std::memory_order_relaxed);
+            worker_cvar.notify_one();
+        }
+
+        // launched hedges are still run on shutdown so no caller waits on one forever
+        void run_worker() {
+            std::unique_lock<std::mutex> lock(mtx);
+            while (true) {
+                worker_cvar.wait(lock, [this]() { return stopping || !launches.empty(); });
+                if (launches.empty())
+                    break;
+
+                std::shared_ptr<hedge_state> st = std::move(launches.front());
+                launches.pop_front();
+                lock.unlock();
+
+                run_attempt(*st, 1);
+
+                // a losing hedge recycles its handle and connection here rather than on the caller's time
+                connection_pool::lease conn;
+                std::unique_ptr<statement> stmt;
+                {
+                    std::lock_guard<std::mutex> st_lock(st->mtx);
+                    if (st->winner != 1) {
+                        stmt = std::move(st->attempts[1].stmt);
+                        conn = std::move(st->attempts[1].conn);
+                    }
+                }
+                stmt.reset();
+                conn = connection_pool::lease{};
+
+                lock.lock();
+                idle_workers++;
+            }
+        }
+
+        // --------------------------------------------------
+        // READ
+        // --------------------------------------------------
+
+        hedged_reader::read_result execute(std::string_view sql, const hedged_reader::binder& bind, const hedged_reader::consumer& consume) {
+            hedged_reader::read_result result;
+            reads.fetch_add(1, std::memory_order_relaxed);
+            if (pools.empty()) {
+                result.error = std::string{"the reader has no connection pools"};
+                return result;
+            }
+
+            auto st = std::make_shared<hedge_state>();
+            st->sql = std::string(sql);
+            st->bind = &bind;
+            std::size_t first = next_pool.fetch_add(1, std::memory_order_relaxed) % pools.size();
+            st->attempts[0].pool = pools[first];
+            st->attempts[1].pool = pools[(first + 1) % pools.size()];
+
+            // the timer and the latency sample both start here
+            auto begin = std::chrono::steady_clock::now();
+            std::int64_t delay = hedge_delay_ns.load(std::memory_order_relaxed);
+            if (delay >= 0 && !workers.empty()) {
+                std::lock_guard<std::mutex> lock(mtx);
+                pending.emplace(begin + std::chrono::nanoseconds(delay), st);
+                timer_cvar.notify_one();
+            }
+
+            if (run_attempt(*st, 0))
+                record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin));
+
+            // a hedge that reads the bound parameters is waited for until its execute returns, one still acquiring or
+            // preparing is left behind once the first attempt has won since it stops before binding, after a failed
+            // first attempt the hedge is the only one left and is waited for to the end
+            std::unique_lock<std::mutex> lock(st->mtx);
+            st->cvar.wait(lock, [&st]() {
+                const hedge_attempt& hedge = st->attempts[1];
+                return !st->hedge_launched || hedge.finished || (st->winner == 0 && !hedge.binding);
+            });
+            result.hedged = st->hedge_launched;
+
+            connection_pool::lease first_conn = std::move(st->attempts[0].conn);
+            std::unique_ptr<statement> first_stmt = std::move(st->attempts[0].stmt);
+            if (st->winner < 0) {
+                result.error = st->attempts[0].error.empty() ? st->attempts[1].error : st->attempts[0].error;
+                return result;
+            }
+
+            connection_pool::lease conn;
+            std::unique_ptr<statement> stmt;
+            if (st->winner == 0) {
+                conn = std::move(first_conn);
+                stmt = std::move(first_stmt);
+            } else {
+                conn = std::move(st->attempts[1].conn);
+                stmt = std::move(st->attempts[1].stmt);
+                result.hedge_won = true;
+                hedge_wins.fetch_add(1, std::memory_order_relaxed);
+            }
+            lock.unlock();
+
+            result.ok = consume(*stmt);
+            if (!result.ok)
+                result.error = std::string(stmt->last_error());
+            return result;
+        }
+
+        hedged_reader::hedge_stats stats() {
+            hedged_reader::hedge_stats s;
+            s.reads = reads.load(std::memory_order_relaxed);
+            s.hedged = hedged.load(std::memory_order_relaxed);
+            s.hedge_wins = hedge_wins.load(std::memory_order_relaxed);
+            s.skipped = skipped.load(std::memory_order_relaxed);
+
+            std::int64_t delay = hedge_delay_ns.load(std::memory_order_relaxed);
+            s.hedge_delay = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::nanoseconds(delay < 0 ? 0 : delay));
+            return s;
+        }
+    };
+
+    hedged_reader::hedged_reader(const std::vector<std::reference_wrapper<connection_pool>>& pools, const hedged_reader::alloc_options& options) : m_reader(std::make_unique<reader>(pools, options)) {}
+
+    hedged_reader::~hedged_reader() = default;
+
+    hedged_reader::read_result hedged_reader::execute(std::string_view sql, const binder& bind, const consumer& consume) {
+        return m_reader.get()->execute(sql, bind, consume);
+    }
+
+    hedged_reader::hedge_stats hedged_reader::stats() {
+        return m_reader.get()->stats();
+    }
+
+}
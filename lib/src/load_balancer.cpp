@@ -0,0 +1,208 @@
+// SimQL stuff
+#include "load_balancer.hpp"
+#include "connection_pool.hpp"
+#include "simql_queues.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+#include <functional>
+
+namespace simql {
+
+    // each endpoint on its own cache line, every acquire and release touches in_flight
+    struct alignas(simql_queues::cache_line_size) balanced_endpoint {
+        connection_pool& pool;
+        std::atomic<double> latency_ns{0.0};
+        std::atomic<std::int64_t> last_sample_ns{0};
+        std::atomic<std::uint32_t> in_flight{0};
+        std::atomic<std::uint64_t> selected{0};
+        std::atomic<std::uint64_t> samples{0};
+
+        explicit balanced_endpoint(connection_pool& endpoint_pool) : pool(endpoint_pool) {}
+    };
+
+    static std::int64_t steady_ns() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    struct load_balancer::balancer {
+        std::vector<std::unique_ptr<balanced_endpoint>> endpoints;
+        load_balancer::alloc_options opts;
+        double decay_ns;
+
+        balancer(const std::vector<std::reference_wrapper<connection_pool>>& pools, const load_balancer::alloc_options& options) : opts(options) {
+            endpoints.reserve(pools.size());
+            for (connection_pool& pool : pools)
+                endpoints.push_back(std::make_unique<balanced_endpoint>(pool));
+
+            if (opts.decay_time.count() <= 0)
+                opts.decay_time = std::chrono::milliseconds(1);
+            decay_ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(opts.decay_time).count());
+        }
+
+        // the weight an average carries after age nanoseconds
+        double decay(std::int64_t age) const {
+            return age <= 0 ? 1.0 : std::exp2(-static_cast<double>(age) / decay_ns);
+        }
+
+        // the average fades while no samples arrive, so an endpoint that was avoided gets tried again
+        double latency(const balanced_endpoint& e, std::int64_t now) const {
+            std::int64_t last = e.last_sample_ns.load(std::memory_order_relaxed);
+            return e.latency_ns.load(std::memory_order_relaxed) * decay(now - last);
+        }
+
+        double score(const balanced_endpoint& e, std::int64_t now) const {
+            return (latency(e, now) + 1.0) * static_cast<double>(e.in_flight.load(std::memory_order_relaxed) + 1);
+        }
+
+        // concurrent samples may interleave between the exchange and the CAS, which only blurs the weighting
+        void record(std::size_t index, std::chrono::nanoseconds elapsed) {
+            balanced_endpoint& e = *endpoints[index];
+            std::int64_t now = steady_ns();
+            std::int64_t last = e.last_sample_ns.exchange(now, std::memory_order_relaxed);
+            double weight = last == 0 ? 0.0 : decay(now - last);
+            double sample = static_cast<double>(elapsed.count() > 0 ? elapsed.count() : 0);
+
+            double current = e.latency_ns.load(std::memory_order_relaxed);
+            while (!e.latency_ns.compare_exchange_weak(current, current * weight + sample * (1.0 - weight), std::memory_order_relaxed)) {}
+            e.samples.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // power of two choices, the two candidates are always distinct
+        std::size_t choose() {
+            static thread_local std::minstd_rand rng{std::random_device{}()};
+
+            std::size_t count = endpoints.size();
+            if (count == 1)
+                return 0;
+
+            std::size_t first = rng() % count;
+            std::size_t second = rng() % (count - 1);
+            if (second >= first)
+                second++;
+
+            std::int64_t now = steady_ns();
+            return score(*endpoints[first], now) <= score(*endpoints[second], now) ? first : second;
+        }
+
+        // a zero deadline means the pool's own acquire timeout
+        load_balancer::lease acquire(std::chrono::steady_clock::time_point deadline) {
+            if (endpoints.empty())
+                return load_balancer::lease{};
+
+            std::size_t index = choose();
+            balanced_endpoint& e = *endpoints[index];
+            e.selected.fetch_add(1, std::memory_order_relaxed);
+            e.in_flight.fetch_add(1, std::memory_order_relaxed);
+
+            connection_pool::lease conn = deadline == std::chrono::steady_clock::time_point{} ? e.pool.acquire() : e.pool.acquire(deadline);
+            if (!conn.is_valid()) {
+                e.in_flight.fetch_sub(1, std::memory_order_relaxed);
+                record(index, std::chrono::duration_cast<std::chrono::nanoseconds>(opts.failure_penalty));
+                return load_balancer::lease{};
+            }
+
+            return load_balancer::lease(this, index, std::move(conn));
+        }
+
+        void release(std::size_t index) {
+            endpoints[index]->in_flight.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        std::vector<load_balancer::endpoint_stats> stats() {
+            std::int64_t now = steady_ns();
+            std::vector<load_balancer::endpoint_stats> result;
+            result.reserve(endpoints.size());
+            for (std::unique_ptr<balanced_endpoint>& e : endpoints) {
+                load_balancer::endpoint_stats s;
+                s.latency = std::chrono::microseconds(static_cast<std::int64_t>(latency(*e, now) / 1000.0));
+                s.in_flight = e->in_flight.load(std::memory_order_relaxed);
+                s.selected = e->selected.load(std::memory_order_relaxed);
+                s.samples = e->samples.load(std::memory_order_relaxed);
+                result.push_back(s);
+            }
+            return result;
+        }
+    };
+
+    // --------------------------------------------------
+    // LEASE
+    // --------------------------------------------------
+
+    load_balancer::lease::lease(balancer* owner, std::size_t endpoint, connection_pool::lease conn) : m_owner(owner), m_endpoint(endpoint), m_connection(std::move(conn)) {}
+
+    load_balancer::lease::~lease() {
+        give_back();
+    }
+
+    load_balancer::lease::lease(lease&& other) noexcept : m_owner(other.m_owner), m_endpoint(other.m_endpoint), m_connection(std::move(other.m_connection)) {
+        other.m_owner = nullptr;
+    }
+
+    load_balancer::lease& load_balancer::lease::operator=(lease&& other) noexcept {
+        if (this != &other) {
+            give_back();
+            m_owner = other.m_owner;
+            m_endpoint = other.m_endpoint;
+            m_connection = std::move(other.m_connection);
+            other.m_owner = nullptr;
+        }
+        return *this;
+    }
+
+    bool load_balancer::lease::is_valid() const {
+        return m_owner != nullptr && m_connection.is_valid();
+    }
+
+    std::size_t load_balancer::lease::endpoint() const {
+        return m_endpoint;
+    }
+
+    database_connection& load_balancer::lease::connection() {
+        return m_connection.connection();
+    }
+
+    database_connection* load_balancer::lease::operator->() {
+        return m_connection.operator->();
+    }
+
+    void load_balancer::lease::record(std::chrono::nanoseconds elapsed) {
+        if (m_owner)
+            m_owner->record(m_endpoint, elapsed);
+    }
+
+    void load_balancer::lease::give_back() {
+        m_connection = connection_pool::lease{};
+        if (m_owner)
+            m_owner->release(m_endpoint);
+
+        m_owner = nullptr;
+    }
+
+    // --------------------------------------------------
+    // BALANCER
+    // --------------------------------------------------
+
+    load_balancer::load_balancer(const std::vector<std::reference_wrapper<connection_pool>>& endpoints, const load_balancer::alloc_options& options) : m_balancer(std::make_unique<balancer>(endpoints, options)) {}
+
+    load_balancer::~load_balancer() = default;
+
+    load_balancer::lease load_balancer::acquire() {
+        return m_balancer.get()->acquire(std::chrono::steady_clock::time_point{});
+    }
+
+    load_balancer::lease load_balancer::acquire(std::chrono::steady_clock::time_point deadline) {
+        return m_balancer.get()->acquire(deadline);
+    }
+
+    std::vector<load_balancer::endpoint_stats> load_balancer::stats() {
+        return m_balancer.get()->stats();
+    }
+
+}
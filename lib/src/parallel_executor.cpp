@@ -0,0 +1,176 @@
+// SimQL stuff
+#include "parallel_executor.hpp"
+#include "connection_pool.hpp"
+#include "statement.hpp"
+#include "simql_strings.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <string>
+#include <functional>
+#include <utility>
+
+namespace simql {
+
+    struct queued_query {
+        parallel_executor::query q;
+        parallel_executor::completion done;
+        std::chrono::steady_clock::time_point submitted;
+    };
+
+    struct parallel_executor::executor {
+        connection_pool& pool;
+        parallel_executor::alloc_options opts;
+        std::mutex mtx;
+        std::condition_variable cvar;
+        std::deque<queued_query> pending;
+        std::vector<std::thread> workers;
+        bool stopping{false};
+
+        executor(connection_pool& query_pool, const parallel_executor::alloc_options& options) : pool(query_pool), opts(options) {
+            if (opts.max_parallel_queries == 0)
+                opts.max_parallel_queries = 1;
+
+            workers.reserve(opts.max_parallel_queries);
+            for (std::uint32_t i = 0; i < opts.max_parallel_queries; i++)
+                workers.emplace_back([this]() { work(); });
+        }
+
+        ~executor() {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+            }
+            cvar.notify_all();
+
+            for (std::thread& worker : workers)
+                worker.join();
+        }
+
+        void submit(parallel_executor::query q, parallel_executor::completion done) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                pending.push_back(queued_query{std::move(q), std::move(done), std::chrono::steady_clock::now()});
+            }
+            cvar.notify_one();
+        }
+
+        // the workers drain the queue before they stop
+        void work() {
+            while (true) {
+                queued_query next;
+                {
+                    std::unique_lock<std::mutex> lock(mtx);
+                    cvar.wait(lock, [this]() { return stopping || !pending.empty(); });
+                    if (pending.empty())
+                        return;
+
+                    next = std::move(pending.front());
+                    pending.pop_front();
+                }
+
+                // a bind or consume that throws fails its query rather than the worker
+                parallel_executor::query_result result;
+                try {
+                    result = execute(next);
+                } catch (...) {
+                    result.ok = false;
+                    result.error = simql_strings::from_exception(std::current_exception());
+                }
+
+                if (next.done) {
+                    try {
+                        next.done(std::move(result));
+                    } catch (...) {}
+                }
+            }
+        }
+
+        // every query gets its own statement, the connection's statement cache keeps repeated SQL prepared
+        parallel_executor::query_result execute(queued_query& item) {
+            auto started = std::chrono::steady_clock::now();
+            parallel_executor::query_result result;
+            result.queued = std::chrono::duration_cast<std::chrono::microseconds>(started - item.submitted);
+
+            auto finish = [&](bool ok, std::string error) {
+                result.ok = ok;
+                result.error = std::move(error);
+                result.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started);
+                return std::move(result);
+            };
+
+            connection_pool::lease conn = pool.acquire();
+            if (!conn.is_valid())
+                return finish(false, std::string{"could not acquire a connection from the pool"});
+
+            statement stmt(conn.connection(), opts.statement_options);
+            if (!stmt.is_valid())
+                return finish(false, std::string(stmt.last_error()));
+
+            if (!stmt.prepare(item.q.sql))
+                return finish(false, std::string(stmt.last_error()));
+
+            if (item.q.bind && !item.q.bind(stmt))
+                return finish(false, stmt.last_error().empty() ? std::string{"could not bind the parameters"} : std::string(stmt.last_error()));
+
+            if (!stmt.execute())
+                return finish(false, std::string(stmt.last_error()));
+
+            if (item.q.consume && !item.q.consume(stmt))
+                return finish(false, stmt.last_error().empty() ? std::string{"could not consume the results"} : std::string(stmt.last_error()));
+
+            return finish(true, std::string{});
+        }
+
+        std::size_t queued() {
+            std::lock_guard<std::mutex> lock(mtx);
+            return pending.size();
+        }
+    };
+
+    // --------------------------------------------------
+    // EXECUTOR
+    // --------------------------------------------------
+
+    parallel_executor::parallel_executor(connection_pool& pool, const parallel_executor::alloc_options& options) : m_executor(std::make_unique<executor>(pool, options)) {}
+
+    parallel_executor::~parallel_executor() = default;
+
+    std::future<parallel_executor::query_result> parallel_executor::submit(parallel_executor::query q) {
+        auto promise = std::make_shared<std::promise<parallel_executor::query_result>>();
+        std::future<parallel_executor::query_result> future = promise->get_future();
+        m_executor.get()->submit(std::move(q), [promise](parallel_executor::query_result result) { promise->set_value(std::move(result)); });
+        return future;
+    }
+
+    void parallel_executor::submit(parallel_executor::query q, parallel_executor::completion done) {
+        m_executor.get()->submit(std::move(q), std::move(done));
+    }
+
+    std::vector<parallel_executor::query_result> parallel_executor::run(std::vector<parallel_executor::query> batch) {
+        std::vector<std::future<parallel_executor::query_result>> futures;
+        futures.reserve(batch.size());
+        for (parallel_executor::query& q : batch)
+            futures.push_back(submit(std::move(q)));
+
+        std::vector<parallel_executor::query_result> results;
+        results.reserve(futures.size());
+        for (std::future<parallel_executor::query_result>& f : futures)
+            results.push_back(f.get());
+        return results;
+    }
+
+    std::size_t parallel_executor::queued() {
+        return m_executor.get()->queued();
+    }
+
+}
@@ -0,0 +1,408 @@
+// SimQL stuff
+#include "partitioned_scan.hpp"
+#include "connection_pool.hpp"
+#include "statement.hpp"
+#include "simql_types.hpp"
+#include "simql_strings.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace simql {
+
+    struct scan_partition {
+        partitioned_scan::partition_report report{};
+        std::deque<std::vector<statement::sql_row>> rowsets{};
+        statement* running{nullptr};
+        bool done{false};
+    };
+
+    // the columns are owned through shared_ptr so the derived column type is destroyed, sql_column has no virtual destructor
+    static bool define_column(statement& stmt, std::uint8_t position, const partitioned_scan::result_column& column, std::vector<std::shared_ptr<statement::sql_column>>& columns) {
+        auto attach = [&]<typename C>(std::shared_ptr<C> col) {
+            columns.push_back(col);
+            return stmt.define_columns(*col);
+        };
+
+        switch (column.type) {
+        case simql_types::sql_data_type::string:
+            return attach(std::make_shared<statement::sql_column_string>(position, column.max_size, false));
+        case simql_types::sql_data_type::wide_string:
+            return attach(std::make_shared<statement::sql_column_string>(position, column.max_size, true));
+        case simql_types::sql_data_type::character:
+            return attach(std::make_shared<statement::sql_column_character>(position));
+        case simql_types::sql_data_type::boolean:
+            return attach(std::make_shared<statement::sql_column_boolean>(position));
+        case simql_types::sql_data_type::float64:
+            return attach(std::make_shared<statement::sql_column_double>(position));
+        case simql_types::sql_data_type::float32:
+            return attach(std::make_shared<statement::sql_column_float>(position));
+        case simql_types::sql_data_type::int8:
+            return attach(std::make_shared<statement::sql_column_int8>(position));
+        case simql_types::sql_data_type::int16:
+            return attach(std::make_shared<statement::sql_column_int16>(position));
+        case simql_types::sql_data_type::int32:
+            return attach(std::make_shared<statement::sql_column_int32>(position));
+        case simql_types::sql_data_type::int64:
+            return attach(std::make_shared<statement::sql_column_int64>(position));
+        case simql_types::sql_data_type::guid:
+            return attach(std::make_shared<statement::sql_column_guid>(position));
+        case simql_types::sql_data_type::datetime:
+            return attach(std::make_shared<statement::sql_column_datetime>(position));
+        case simql_types::sql_data_type::date:
+            return attach(std::make_shared<statement::sql_column_date>(position));
+        case simql_types::sql_data_type::time:
+            return attach(std::make_shared<statement::sql_column_time>(position));
+        case simql_types::sql_data_type::blob:
+            return attach(std::make_shared<statement::sql_column_blob>(position, column.max_size));
+        }
+        return false;
+    }
+
+    static std::chrono::microseconds since(std::chrono::steady_clock::time_point begin) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin);
+    }
+
+    struct partitioned_scan::scanner {
+        connection_pool& pool;
+        partitioned_scan::alloc_options opts;
+
+        // state of the scan that is running
+        std::mutex mtx;
+        std::condition_variable cvar;
+        std::vector<scan_partition> partitions;
+        bool stopping{false};
+        std::string error{};
+
+        scanner(connection_pool& scan_pool, const partitioned_scan::alloc_options& options) : pool(scan_pool), opts(options) {
+            opts.partitions = std::max<std::uint32_t>(opts.partitions, 1);
+            opts.buffered_rowsets = std::max<std::uint32_t>(opts.buffered_rowsets, 1);
+        }
+
+        // --------------------------------------------------
+        // PARTITIONING
+        // --------------------------------------------------
+
+        std::string where_clause(const partitioned_scan::scan_spec& spec) const {
+            return spec.filter.empty() ? std::string{} : std::string{" WHERE ("} + spec.filter + std::string{")"};
+        }
+
+        // an empty source leaves both bounds unset and the scan has nothing to do
+        bool key_bounds(const partitioned_scan::scan_spec& spec, bool& is_empty, std::int64_t& lower, std::int64_t& upper, std::string& bounds_error) {
+            connection_pool::lease conn = pool.acquire();
+            if (!conn.is_valid()) {
+                bounds_error = std::string{"could not acquire a connection from the pool"};
+                return false;
+            }
+
+            statement stmt(conn.connection(), opts.statement_options);
+            statement::sql_column_int64 min_key(0);
+            statement::sql_column_int64 max_key(1);
+            std::string sql = std::string{"SELECT MIN("} + spec.key_column + std::string{"), MAX("} + spec.key_column + std::string{") FROM "} + spec.source + where_clause(spec);
+            if (!stmt.is_valid() || !stmt.prepare(sql) || !stmt.define_columns(min_key, max_key) || !stmt.execute()) {
+                bounds_error = std::string(stmt.last_error());
+                return false;
+            }
+
+            is_empty = stmt.at_end() || min_key.value.is_null() || max_key.value.is_null();
+            if (!is_empty) {
+                lower = min_key.data();
+                upper = max_key.data();
+            }
+            return true;
+        }
+
+        // the span is counted in unsigned arithmetic so the full int64 range does not overflow
+        void split(const partitioned_scan::scan_spec& spec, std::int64_t lower, std::int64_t upper) {
+            std::vector<std::int64_t> starts{lower};
+            if (!spec.boundaries.empty()) {
+                std::vector<std::int64_t> boundaries = spec.boundaries;
+                std::sort(boundaries.begin(), boundaries.end());
+                for (std::int64_t boundary : boundaries) {
+                    if (boundary > starts.back() && boundary <= upper)
+                        starts.push_back(boundary);
+                }
+            } else {
+                std::uint64_t span = static_cast<std::uint64_t>(upper) - static_cast<std::uint64_t>(lower) + 1;
+                if (span == 0)
+                    span = ~std::uint64_t{0};
+
+                std::uint64_t count = std::min<std::uint64_t>(opts.partitions, span);
+                std::uint64_t width = span / count;
+                std::uint64_t remainder = span % count;
+                for (std::uint64_t i = 1; i < count; i++)
+                    starts.push_back(static_cast<std::int64_t>(static_cast<std::uint64_t>(lower) + i * width + std::min(i, remainder)));
+            }
+
+            partitions = std::vector<scan_partition>(starts.size());
+            for (std::size_t i = 0; i < starts.size(); i++) {
+                partitions[i].report.lower = starts[i];
+                partitions[i].report.upper = i + 1 < starts.size() ? starts[i + 1] - 1 : upper;
+            }
+        }
+
+        // --------------------------------------------------
+        // PARTITION WORKERS
+        // --------------------------------------------------
+
+        // requires mtx, the first failure is the scan's error and interrupts every partition still executing
+        void stop(std::unique_lock<std::mutex>& lock, std::string reason) {
+            if (!stopping && !reason.empty())
+                error = std::move(reason);
+            stopping = true;
+
+            for (scan_partition& p : partitions) {
+                if (p.running)
+                    p.running->cancel();
+            }
+            lock.unlock();
+            cvar.notify_all();
+            lock.lock();
+        }
+
+        // blocks while the partition's buffer is full, false once the scan stops
+        bool deliver(scan_partition& p, std::vector<statement::sql_row>&& rowset) {
+            std::unique_lock<std::mutex> lock(mtx);
+            cvar.wait(lock, [&]() { return stopping || p.rowsets.size() < opts.buffered_rowsets; });
+            if (stopping)
+                return false;
+
+            p.report.rows += rowset.size();
+            p.rowsets.push_back(std::move(rowset));
+            lock.unlock();
+            cvar.notify_all();
+            return true;
+        }
+
+        void fail(scan_partition& p, std::string reason) {
+            std::unique_lock<std::mutex> lock(mtx);
+            p.report.error = reason;
+            stop(lock, std::move(reason));
+        }
+
+        void scan(scan_partition& p, const std::string& sql, const partitioned_scan::scan_spec& spec) {
+            connection_pool::lease conn = pool.acquire();
+            if (!conn.is_valid())
+                return fail(p, std::string{"could not acquire a connection from the pool"});
+
+            statement stmt(conn.connection(), opts.statement_options);
+            if (!stmt.is_valid() || !stmt.prepare(sql))
+                return fail(p, std::string(stmt.last_error()));
+
+            std::vector<std::shared_ptr<statement::sql_column>> columns;
+            for (std::size_t i = 0; i < spec.columns.size(); i++) {
+                if (!define_column(stmt, static_cast<std::uint8_t>(i), spec.columns[i], columns))
+                    return fail(p, std::string(stmt.last_error()));
+            }
+
+            std::int64_t lower = p.report.lower;
+            std::int64_t upper = p.report.upper;
+            if (!stmt.bind(lower, upper))
+                return fail(p, std::string(stmt.last_error()));
+
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                if (stopping)
+                    return;
+                p.running = &stmt;
+            }
+            bool executed = stmt.execute();
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                p.running = nullptr;
+                if (stopping)
+                    return;
+            }
+            if (!executed)
+                return fail(p, std::string(stmt.last_error()));
+
+            std::size_t rowset_size = std::max<std::size_t>(opts.statement_options.rowset_size, 1);
+            std::vector<statement::sql_row> rowset;
+            rowset.reserve(rowset_size);
+            if (!stmt.at_end()) {
+                do {
+                    statement::sql_row row;
+                    row.reserve(columns.size());
+                    for (std::shared_ptr<statement::sql_column>& col : columns)
+                        row.push_back(col->value);
+                    rowset.push_back(std::move(row));
+
+                    if (rowset.size() >= rowset_size) {
+                        if (!deliver(p, std::move(rowset)))
+                            return;
+                        rowset = std::vector<statement::sql_row>();
+                        rowset.reserve(rowset_size);
+                    }
+                } while (stmt.next_record());
+
+                if (!stmt.at_end())
+                    return fail(p, std::string(stmt.last_error()));
+            }
+
+            if (!rowset.empty())
+                deliver(p, std::move(rowset));
+        }
+
+        // --------------------------------------------------
+        // CONSUMPTION
+        // --------------------------------------------------
+
+        // requires mtx, picks the partition to take the next rowset from, or returns false when none is left
+        bool next_partition(std::size_t& current, std::size_t& index) {
+
+            // the key ranges are disjoint and ascending, so a merge across the partition heads would always pick
+            // the lowest partition that has rows left, which is the one taken here
+            if (opts.ordered) {
+                while (current < partitions.size() && partitions[current].done && partitions[current].rowsets.empty())
+                    current++;
+                index = current;
+                return current < partitions.size();
+            }
+
+            bool remaining{false};
+            for (std::size_t i = 0; i < partitions.size(); i++) {
+                std::size_t candidate = (current + i) % partitions.size();
+                if (!partitions[candidate].rowsets.empty()) {
+                    index = candidate;
+                    current = (candidate + 1) % partitions.size();
+                    return true;
+                }
+                remaining = remaining || !partitions[candidate].done;
+            }
+            index = partitions.size();
+            return remaining;
+        }
+
+        void consume_all(const partitioned_scan::consumer& consume) {
+            std::size_t current{0};
+            std::unique_lock<std::mutex> lock(mtx);
+            while (!stopping) {
+                std::size_t index{0};
+                if (!next_partition(current, index))
+                    return;
+
+                if (index >= partitions.size() || partitions[index].rowsets.empty()) {
+                    cvar.wait(lock);
+                    continue;
+                }
+
+                std::vector<statement::sql_row> rowset = std::move(partitions[index].rowsets.front());
+                partitions[index].rowsets.pop_front();
+                lock.unlock();
+                cvar.notify_all();
+
+                // a consumer that throws stops the scan like one that returns false, the partitions are then
+                // released and joined by run as usual
+                bool carry_on{false};
+                std::string reason{"the consumer stopped the scan"};
+                try {
+                    carry_on = consume(index, rowset);
+                } catch (...) {
+                    reason = simql_strings::from_exception(std::current_exception());
+                }
+
+                lock.lock();
+                if (!carry_on)
+                    stop(lock, std::move(reason));
+            }
+        }
+
+        partitioned_scan::scan_report run(const partitioned_scan::scan_spec& spec, const partitioned_scan::consumer& consume) {
+            auto begin = std::chrono::steady_clock::now();
+            partitioned_scan::scan_report report;
+            if (spec.columns.empty()) {
+                report.error = std::string{"no columns to scan"};
+                return report;
+            }
+
+            bool is_empty{false};
+            std::int64_t lower{0};
+            std::int64_t upper{0};
+            if (!key_bounds(spec, is_empty, lower, upper, report.error)) {
+                report.elapsed = since(begin);
+                return report;
+            }
+
+            if (is_empty) {
+                report.ok = true;
+                report.elapsed = since(begin);
+                return report;
+            }
+
+            stopping = false;
+            error.clear();
+            split(spec, lower, upper);
+
+            // every partition runs the same SQL with its own bounds
+            std::string sql = std::string{"SELECT "};
+            for (std::size_t i = 0; i < spec.columns.size(); i++) {
+                if (i > 0)
+                    sql += std::string{", "};
+                sql += spec.columns[i].name;
+            }
+            sql += std::string{" FROM "} + spec.source + std::string{" WHERE "} + spec.key_column + std::string{" BETWEEN ? AND ?"};
+            if (!spec.filter.empty())
+                sql += std::string{" AND ("} + spec.filter + std::string{")"};
+            if (opts.ordered)
+                sql += std::string{" ORDER BY "} + spec.key_column;
+
+            std::vector<std::thread> workers;
+            workers.reserve(partitions.size());
+            for (scan_partition& p : partitions) {
+                workers.emplace_back([this, &p, &sql, &spec]() {
+                    auto started = std::chrono::steady_clock::now();
+                    scan(p, sql, spec);
+
+                    std::lock_guard<std::mutex> lock(mtx);
+                    p.report.elapsed = since(started);
+                    p.done = true;
+                    cvar.notify_all();
+                });
+            }
+
+            consume_all(consume);
+            {
+                std::unique_lock<std::mutex> lock(mtx);
+                if (stopping)
+                    stop(lock, std::string{});
+            }
+            for (std::thread& worker : workers)
+                worker.join();
+
+            report.ok = !stopping;
+            report.error = error;
+            for (scan_partition& p : partitions) {
+                report.rows += p.report.rows;
+                report.partitions.push_back(p.report);
+            }
+            partitions.clear();
+            report.elapsed = since(begin);
+            return report;
+        }
+    };
+
+    // --------------------------------------------------
+    // SCAN
+    // --------------------------------------------------
+
+    partitioned_scan::partitioned_scan(connection_pool& pool, const partitioned_scan::alloc_options& options) : m_scanner(std::make_unique<scanner>(pool, options)) {}
+
+    partitioned_scan::~partitioned_scan() = default;
+
+    partitioned_scan::scan_report partitioned_scan::run(const partitioned_scan::scan_spec& spec, const partitioned_scan::consumer& consume) {
+        return m_scanner.get()->run(spec, consume);
+    }
+
+}
@@ -0,0 +1,198 @@
+// SimQL stuff
+#include "query_awaitables.hpp"
+#include "async_reactor.hpp"
+#include "connection_pool.hpp"
+#include "database_connection.hpp"
+#include "statement.hpp"
+#include "simql_types.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <chrono>
+#include <coroutine>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <algorithm>
+#include <utility>
+
+namespace simql {
+
+    struct watched_call {
+        async_executor::poll_function poll;
+        std::coroutine_handle<> waiter;
+    };
+
+    struct event_loop::loop {
+        event_loop::alloc_options opts;
+        std::mutex mtx;
+        std::condition_variable wake;
+        std::vector<watched_call> incoming;
+        std::vector<watched_call> active;
+        std::chrono::microseconds interval;
+        std::size_t watched{0};
+
+        explicit loop(const event_loop::alloc_options& options) : opts(options) {
+            if (opts.poll_interval.count() <= 0)
+                opts.poll_interval = std::chrono::microseconds(1);
+            if (opts.max_poll_interval < opts.poll_interval)
+                opts.max_poll_interval = opts.poll_interval;
+            interval = opts.poll_interval;
+        }
+
+        void watch(async_executor::poll_function poll, std::coroutine_handle<> waiter) {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                incoming.push_back(watched_call{std::move(poll), waiter});
+                watched++;
+            }
+            wake.notify_one();
+        }
+
+        // a resumed coroutine may watch its next call right away, which lands in incoming for the next round
+        bool run_once() {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                for (watched_call& call : incoming)
+                    active.push_back(std::move(call));
+                incoming.clear();
+            }
+
+            std::size_t finished{0};
+            for (std::size_t i = 0; i < active.size();) {
+                if (active[i].poll() == simql_types::async_status::pending) {
+                    i++;
+                    continue;
+                }
+
+                std::coroutine_handle<> waiter = active[i].waiter;
+                active[i] = std::move(active.back());
+                active.pop_back();
+                finished++;
+                waiter.resume();
+            }
+
+            std::lock_guard<std::mutex> lock(mtx);
+            watched -= finished;
+            interval = finished > 0 ? opts.poll_interval : std::min(interval * 2, opts.max_poll_interval);
+            return watched > 0;
+        }
+
+        // sleeps between rounds while nothing finishes, a newly watched call cuts the sleep short
+        void run() {
+            while (run_once()) {
+                std::unique_lock<std::mutex> lock(mtx);
+                wake.wait_for(lock, interval, [this]() { return !incoming.empty(); });
+            }
+        }
+
+        std::size_t pending() {
+            std::lock_guard<std::mutex> lock(mtx);
+            return watched;
+        }
+    };
+
+    // --------------------------------------------------
+    // EXECUTORS
+    // --------------------------------------------------
+
+    event_loop::event_loop(const event_loop::alloc_options& options) : m_loop(std::make_unique<loop>(options)) {}
+
+    event_loop::~event_loop() = default;
+
+    void event_loop::watch(async_executor::poll_function poll, std::coroutine_handle<> waiter) {
+        m_loop.get()->watch(std::move(poll), waiter);
+    }
+
+    void event_loop::run() {
+        m_loop.get()->run();
+    }
+
+    bool event_loop::run_once() {
+        return m_loop.get()->run_once();
+    }
+
+    std::size_t event_loop::pending() {
+        return m_loop.get()->pending();
+    }
+
+    void reactor_executor::watch(async_executor::poll_function poll, std::coroutine_handle<> waiter) {
+        m_reactor.watch(std::move(poll), [waiter](bool) { waiter.resume(); });
+    }
+
+    // --------------------------------------------------
+    // AWAITABLES
+    // --------------------------------------------------
+
+    query_awaitable::query_awaitable(async_executor& executor, async_executor::poll_function start, async_executor::poll_function poll) : m_executor(executor), m_start(std::move(start)), m_poll(std::move(poll)) {}
+
+    bool query_awaitable::await_ready() {
+        m_status = m_start();
+        return m_status != simql_types::async_status::pending;
+    }
+
+    // the awaitable lives in the suspended coroutine's frame, so the poll may write the outcome into it
+    void query_awaitable::await_suspend(std::coroutine_handle<> waiter) {
+        m_executor.watch([this]() { return m_status = m_poll(); }, waiter);
+    }
+
+    bool query_awaitable::await_resume() const {
+        return m_status == simql_types::async_status::complete;
+    }
+
+    lease_awaitable::lease_awaitable(async_executor& executor, connection_pool& pool, std::chrono::steady_clock::time_point deadline) : m_executor(executor), m_pool(pool), m_deadline(deadline) {}
+
+    // a coroutine destroyed while it was queued leaves the pool's queue here
+    lease_awaitable::~lease_awaitable() {
+        m_pool.cancel_acquire(m_waiter);
+    }
+
+    simql_types::async_status lease_awaitable::try_lease() {
+        return m_pool.poll_acquire(m_waiter, m_deadline, m_lease);
+    }
+
+    bool lease_awaitable::await_ready() {
+        return try_lease() != simql_types::async_status::pending;
+    }
+
+    void lease_awaitable::await_suspend(std::coroutine_handle<> waiter) {
+        m_executor.watch([this]() { return try_lease(); }, waiter);
+    }
+
+    connection_pool::lease lease_awaitable::await_resume() {
+        return std::move(m_lease);
+    }
+
+    query_awaitable async_prepare(statement& stmt, std::string_view sql, async_executor& executor) {
+        return query_awaitable(executor, [&stmt, sql = std::string(sql)]() { return stmt.prepare_async(sql); }, [&stmt]() { return stmt.poll(); });
+    }
+
+    query_awaitable async_execute(statement& stmt, async_executor& executor) {
+        return query_awaitable(executor, [&stmt]() { return stmt.execute_async(); }, [&stmt]() { return stmt.poll(); });
+    }
+
+    query_awaitable async_execute_direct(statement& stmt, std::string_view sql, async_executor& executor) {
+        return query_awaitable(executor, [&stmt, sql = std::string(sql)]() { return stmt.execute_direct_async(sql); }, [&stmt]() { return stmt.poll(); });
+    }
+
+    query_awaitable async_next_record(statement& stmt, async_executor& executor) {
+        return query_awaitable(executor, [&stmt]() { return stmt.next_record_async(); }, [&stmt]() { return stmt.poll(); });
+    }
+
+    query_awaitable async_connect(database_connection& dbc, std::string connection_string, async_executor& executor) {
+        return query_awaitable(executor, [&dbc, connection_string = std::move(connection_string)]() { return dbc.connect_async(connection_string); }, [&dbc]() { return dbc.poll_connect(); });
+    }
+
+    lease_awaitable async_acquire(connection_pool& pool, async_executor& executor) {
+        return lease_awaitable(executor, pool, std::chrono::steady_clock::time_point::max());
+    }
+
+    lease_awaitable async_acquire(connection_pool& pool, async_executor& executor, std::chrono::steady_clock::time_point deadline) {
+        return lease_awaitable(executor, pool, deadline);
+    }
+
+}
@@ -0,0 +1,180 @@
+// SimQL stuff
+#include "query_router.hpp"
+#include "connection_pool.hpp"
+#include "database_connection.hpp"
+#include "statement.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <functional>
+
+namespace simql {
+
+    // in_rotation is read on every routed acquire, the rest only by the prober and under mtx
+    struct routed_replica {
+        connection_pool& pool;
+        std::atomic<bool> in_rotation{true};
+        std::uint32_t consecutive_failures{0};
+        std::uint32_t consecutive_successes{0};
+        query_router::replica_status status{};
+
+        explicit routed_replica(connection_pool& replica_pool) : pool(replica_pool) {}
+    };
+
+    struct query_router::router {
+        connection_pool& primary;
+        std::vector<std::unique_ptr<routed_replica>> replicas;
+        query_router::alloc_options opts;
+        std::atomic<std::size_t> next_replica{0};
+
+        std::mutex mtx;
+        std::condition_variable prober_cvar;
+        std::thread prober;
+        bool stopping{false};
+
+        router(connection_pool& primary_pool, const std::vector<std::reference_wrapper<connection_pool>>& replica_pools, const query_router::alloc_options& options) : primary(primary_pool), opts(options) {
+            replicas.reserve(replica_pools.size());
+            for (connection_pool& replica : replica_pools)
+                replicas.push_back(std::make_unique<routed_replica>(replica));
+
+            if (opts.failures_to_eject == 0)
+                opts.failures_to_eject = 1;
+
+            if (opts.successes_to_restore == 0)
+                opts.successes_to_restore = 1;
+
+            if (opts.probe_interval.count() > 0 && !replicas.empty())
+                prober = std::thread([this]() { run_prober(); });
+        }
+
+        ~router() {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+            }
+            prober_cvar.notify_all();
+            if (prober.joinable())
+                prober.join();
+        }
+
+        // nullptr when nothing may serve the read
+        connection_pool* route(query_router::intent route) {
+            if (route == query_router::intent::read_write)
+                return &primary;
+
+            std::size_t count = replicas.size();
+            std::size_t start = next_replica.fetch_add(1, std::memory_order_relaxed);
+            for (std::size_t i = 0; i < count; i++) {
+                routed_replica& replica = *replicas[(start + i) % count];
+                if (replica.in_rotation.load(std::memory_order_acquire))
+                    return &replica.pool;
+            }
+
+            return opts.fallback_to_primary ? &primary : nullptr;
+        }
+
+        // --------------------------------------------------
+        // PROBING
+        // --------------------------------------------------
+
+        void run_prober() {
+            std::unique_lock<std::mutex> lock(mtx);
+            while (!stopping) {
+                prober_cvar.wait_for(lock, opts.probe_interval, [this]() { return stopping; });
+                if (stopping)
+                    break;
+
+                lock.unlock();
+                probe_all();
+                lock.lock();
+            }
+        }
+
+        void probe_all() {
+            for (std::unique_ptr<routed_replica>& replica : replicas)
+                probe(*replica);
+        }
+
+        // the replica is checked through its own pool, so a probe also exercises the pool's connection validation
+        void probe(routed_replica& replica) {
+            std::string error{};
+            std::int64_t lag{0};
+
+            connection_pool::lease conn = replica.pool.acquire(std::chrono::steady_clock::now() + opts.probe_timeout);
+            if (!conn.is_valid()) {
+                error = std::string{"could not acquire a replica connection"};
+            } else if (!conn->is_connected()) {
+                error = std::string{"the replica connection is dead"};
+            } else if (!opts.lag_probe_sql.empty()) {
+                statement stmt(conn.connection(), opts.statement_options);
+                statement::sql_column_int64 lag_column(0);
+                if (!stmt.is_valid() || !stmt.execute_direct(opts.lag_probe_sql) || !stmt.define_columns(lag_column) || !stmt.next_record()) {
+                    error = std::string{"the lag probe failed: "} + std::string(stmt.last_error());
+                } else {
+                    lag = lag_column.data();
+                    if (opts.max_replica_lag > 0 && lag > opts.max_replica_lag)
+                        error = std::string{"the replica is "} + std::to_string(lag) + std::string{" seconds behind"};
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mtx);
+            replica.status.probes++;
+            replica.status.lag = lag;
+            if (error.empty()) {
+                replica.consecutive_failures = 0;
+                if (++replica.consecutive_successes >= opts.successes_to_restore)
+                    replica.in_rotation.store(true, std::memory_order_release);
+                return;
+            }
+
+            replica.status.failed_probes++;
+            replica.status.last_error = std::move(error);
+            replica.consecutive_successes = 0;
+            if (++replica.consecutive_failures >= opts.failures_to_eject)
+                replica.in_rotation.store(false, std::memory_order_release);
+        }
+
+        std::vector<query_router::replica_status> statuses() {
+            std::lock_guard<std::mutex> lock(mtx);
+            std::vector<query_router::replica_status> result;
+            result.reserve(replicas.size());
+            for (std::unique_ptr<routed_replica>& replica : replicas) {
+                query_router::replica_status status = replica->status;
+                status.in_rotation = replica->in_rotation.load(std::memory_order_acquire);
+                result.push_back(std::move(status));
+            }
+            return result;
+        }
+    };
+
+    query_router::query_router(connection_pool& primary, const std::vector<std::reference_wrapper<connection_pool>>& replicas, const query_router::alloc_options& options) : m_router(std::make_unique<router>(primary, replicas, options)) {}
+
+    query_router::~query_router() = default;
+
+    connection_pool::lease query_router::acquire(query_router::intent route) {
+        connection_pool* pool = m_router.get()->route(route);
+        return pool ? pool->acquire() : connection_pool::lease{};
+    }
+
+    connection_pool::lease query_router::acquire(query_router::intent route, std::chrono::steady_clock::time_point deadline) {
+        connection_pool* pool = m_router.get()->route(route);
+        return pool ? pool->acquire(deadline) : connection_pool::lease{};
+    }
+
+    void query_router::probe() {
+        m_router.get()->probe_all();
+    }
+
+    std::vector<query_router::replica_status> query_router::replica_statuses() {
+        return m_router.get()->statuses();
+    }
+
+}
@@ -0,0 +1,336 @@
+// SimQL stuff
+#include "shard_runtime.hpp"
+#include "environment.hpp"
+#include "database_connection.hpp"
+#include "statement.hpp"
+#include "simql_queues.hpp"
+#include "simql_strings.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <exception>
+#include <thread>
+#include <latch>
+#include <list>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+
+// OS stuff
+#include "os_inclusions.hpp"
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace simql {
+
+    struct queued_task {
+        shard_runtime::task work;
+    };
+
+    // the most recently used statement is at the front, index keys point into the entries' own SQL
+    struct shard_statement_cache {
+        struct cached_statement {
+            std::string sql;
+            statement stmt;
+        };
+
+        std::list<cached_statement> entries;
+        std::unordered_map<std::string_view, std::list<cached_statement>::iterator> index;
+    };
+
+    static thread_local shard_runtime::context* t_current_context{nullptr};
+
+    static void pin_to_core(std::uint32_t core) {
+#if defined(_WIN32)
+        SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{1} << (core % (sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(core % CPU_SETSIZE, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+#else
+        (void)core;
+#endif
+    }
+
+    struct shard_runtime::shard {
+        shard_runtime::runtime& owner;
+        std::uint32_t index;
+        shard_runtime::context ctx;
+
+        // producers push from any thread, only the worker pops
+        simql_queues::mpmc_ring<std::unique_ptr<queued_task>> inbox;
+        alignas(simql_queues::cache_line_size) std::atomic<std::uint32_t> wake_epoch{0};
+        std::atomic<bool> sleeping{false};
+        std::thread worker;
+
+        // written before the startup latch and read by the constructor after it
+        std::string connect_error{};
+
+        // touched by the worker thread only
+        std::vector<std::unique_ptr<database_connection>> connections;
+        std::vector<shard_statement_cache> caches;
+        std::string last_error{};
+
+        shard(shard_runtime::runtime& runtime, std::uint32_t shard_index, std::size_t queue_capacity) : owner(runtime), index(shard_index), ctx(this), inbox(queue_capacity) {}
+
+        // pairs with the fence in sleep so either the worker sees the task or this sees the worker asleep
+        void wake() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (sleeping.load(std::memory_order_relaxed)) {
+                wake_epoch.fetch_add(1, std::memory_order_release);
+                wake_epoch.notify_one();
+            }
+        }
+    };
+
+    struct shard_runtime::runtime {
+        environment& env;
+        std::string connection_string;
+        shard_runtime::alloc_options opts;
+        database_connection::alloc_options conn_opts;
+        statement::alloc_options stmt_opts;
+
+        std::vector<std::unique_ptr<shard>> shards;
+        std::atomic<bool> stopping{false};
+
+        // submits that passed the stopping check and may not have pushed yet, the workers wait for them before exiting
+        std::atomic<std::uint32_t> submitting{0};
+
+        bool is_valid{true};
+        std::string last_error{};
+
+        runtime(environment& environment, std::string conn_string, const shard_runtime::alloc_options& runtime_options, const database_connection::alloc_options& conn_options, const statement::alloc_options& stmt_options) : env(environment), connection_string(std::move(conn_string)), opts(runtime_options), conn_opts(conn_options), stmt_opts(stmt_options) {
+            std::uint32_t cores = std::max(1u, std::thread::hardware_concurrency());
+            if (opts.shard_count == 0)
+                opts.shard_count = cores;
+
+            if (opts.statement_cache_size == 0)
+                opts.statement_cache_size = 1;
+
+            shards.reserve(opts.shard_count);
+            for (std::uint32_t i = 0; i < opts.shard_count; i++)
+                shards.push_back(std::make_unique<shard>(*this, i, opts.queue_capacity));
+
+            std::latch ready(static_cast<std::ptrdiff_t>(shards.size()));
+            for (std::unique_ptr<shard>& s : shards) {
+                shard* target = s.get();
+                s->worker = std::thread([this, target, &ready]() { run(*target, ready); });
+            }
+            ready.wait();
+
+            for (std::unique_ptr<shard>& s : shards) {
+                if (s->connect_error.empty())
+                    continue;
+
+                is_valid = false;
+                if (last_error.empty())
+                    last_error = std::string{"shard "} + std::to_string(s->index) + std::string{" could not connect: "} + s->connect_error;
+            }
+        }
+
+        ~runtime() {
+            stopping.store(true);
+            for (std::unique_ptr<shard>& s : shards) {
+                s->wake_epoch.fetch_add(1, std::memory_order_release);
+                s->wake_epoch.notify_one();
+            }
+
+            for (std::unique_ptr<shard>& s : shards) {
+                if (s->worker.joinable())
+                    s->worker.join();
+            }
+        }
+
+        // the count goes up before stopping is checked, so either the destructor's store is seen here or a worker
+        // that saw it also sees this submit in flight
+        bool submit(std::uint32_t target, shard_runtime::task work) {
+            if (target >= shards.size() || !work)
+                return false;
+
+            submitting.fetch_add(1);
+            if (stopping.load()) {
+                submitting.fetch_sub(1, std::memory_order_release);
+                return false;
+            }
+
+            shard& s = *shards[target];
+            bool pushed = s.inbox.try_push(std::make_unique<queued_task>(queued_task{std::move(work)}));
+            if (pushed)
+                s.wake();
+
+            submitting.fetch_sub(1, std::memory_order_release);
+            return pushed;
+        }
+
+        // --------------------------------------------------
+        // WORKER
+        // --------------------------------------------------
+
+        void open_connections(shard& s) {
+            s.connections.reserve(opts.connections_per_shard);
+            s.caches.resize(opts.connections_per_shard);
+            for (std::uint32_t i = 0; i < opts.connections_per_shard; i++) {
+                database_connection::alloc_options options = conn_opts;
+                auto conn = std::make_unique<database_connection>(env, options);
+                if (!conn->is_valid() || !conn->connect(connection_string)) {
+                    if (s.connect_error.empty())
+                        s.connect_error = std::string(conn->last_error());
+                }
+                s.connections.push_back(std::move(conn));
+            }
+        }
+
+        // tasks are drained before the worker honours a stop
+        void run(shard& s, std::latch& ready) {
+            t_current_context = &s.ctx;
+            if (opts.pin_threads)
+                pin_to_core(s.index);
+
+            open_connections(s);
+            ready.count_down();
+
+            std::uint32_t idle_polls{0};
+            std::unique_ptr<queued_task> next;
+            while (true) {
+                if (s.inbox.try_pop(next)) {
+
+                    // a task that throws leaves its message in last_error, the worker carries on
+                    try {
+                        next->work(s.ctx);
+                    } catch (...) {
+                        s.last_error = simql_strings::from_exception(std::current_exception());
+                    }
+                    next.reset();
+                    idle_polls = 0;
+                    continue;
+                }
+
+                // a submit still in flight pushes a task that has to run before the worker leaves
+                if (stopping.load()) {
+                    if (submitting.load() == 0 && s.inbox.size_approx() == 0)
+                        break;
+
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                if (++idle_polls < opts.spin_count) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                sleep(s);
+                idle_polls = 0;
+            }
+
+            // statements go before the connections they were allocated on
+            s.caches.clear();
+            s.connections.clear();
+            t_current_context = nullptr;
+        }
+
+        void sleep(shard& s) {
+            std::uint32_t epoch = s.wake_epoch.load(std::memory_order_acquire);
+            s.sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (s.inbox.size_approx() == 0 && !stopping.load(std::memory_order_relaxed))
+                s.wake_epoch.wait(epoch, std::memory_order_acquire);
+
+            s.sleeping.store(false, std::memory_order_relaxed);
+        }
+    };
+
+    // --------------------------------------------------
+    // CONTEXT
+    // --------------------------------------------------
+
+    shard_runtime::context::context(shard* owner) : m_shard(owner) {}
+
+    std::uint32_t shard_runtime::context::shard_index() const {
+        return m_shard->index;
+    }
+
+    std::size_t shard_runtime::context::connection_count() const {
+        return m_shard->connections.size();
+    }
+
+    database_connection& shard_runtime::context::connection(std::size_t index) {
+        return *m_shard->connections[index];
+    }
+
+    statement* shard_runtime::context::prepared(std::string_view sql, std::size_t connection_index) {
+        shard& s = *m_shard;
+        if (connection_index >= s.connections.size()) {
+            s.last_error = std::string{"the shard has no connection at the provided index"};
+            return nullptr;
+        }
+
+        shard_statement_cache& cache = s.caches[connection_index];
+        auto found = cache.index.find(sql);
+        if (found != cache.index.end()) {
+            cache.entries.splice(cache.entries.begin(), cache.entries, found->second);
+            found->second->stmt.reset_execution_state();
+            return &found->second->stmt;
+        }
+
+        statement stmt(*s.connections[connection_index], s.owner.stmt_opts);
+        if (!stmt.is_valid() || !stmt.prepare(sql)) {
+            s.last_error = std::string(stmt.last_error());
+            return nullptr;
+        }
+
+        while (cache.entries.size() >= s.owner.opts.statement_cache_size) {
+            cache.index.erase(std::string_view(cache.entries.back().sql));
+            cache.entries.pop_back();
+        }
+
+        cache.entries.push_front(shard_statement_cache::cached_statement{std::string(sql), std::move(stmt)});
+        cache.index.emplace(std::string_view(cache.entries.front().sql), cache.entries.begin());
+        return &cache.entries.front().stmt;
+    }
+
+    std::string_view shard_runtime::context::last_error() {
+        return m_shard->last_error;
+    }
+
+    bool shard_runtime::context::submit(std::uint32_t shard, std::function<void(context&)> work) {
+        return m_shard->owner.submit(shard, std::move(work));
+    }
+
+    // --------------------------------------------------
+    // RUNTIME
+    // --------------------------------------------------
+
+    shard_runtime::shard_runtime(environment& env, std::string connection_string, const shard_runtime::alloc_options& runtime_options, const database_connection::alloc_options& conn_options, const statement::alloc_options& stmt_options) : m_runtime(std::make_unique<runtime>(env, std::move(connection_string), runtime_options, conn_options, stmt_options)) {}
+
+    shard_runtime::~shard_runtime() = default;
+
+    bool shard_runtime::submit(std::uint32_t shard, task work) {
+        return m_runtime.get()->submit(shard, std::move(work));
+    }
+
+    std::uint32_t shard_runtime::shard_count() const {
+        return static_cast<std::uint32_t>(m_runtime.get()->shards.size());
+    }
+
+    shard_runtime::context* shard_runtime::current() {
+        return t_current_context;
+    }
+
+    bool shard_runtime::is_valid() {
+        return m_runtime.get()->is_valid;
+    }
+
+    std::string_view shard_runtime::last_error() {
+        return m_runtime.get()->last_error;
+    }
+
+}
@@ -0,0 +1,169 @@
+// SimQL stuff
+#include "simql_metrics.hpp"
+#include "simql_queues.hpp"
+
+// STL stuff
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+namespace simql_metrics {
+
+    struct alignas(simql_queues::cache_line_size) stripe {
+        std::atomic<std::uint64_t> value{0};
+    };
+
+    struct histogram {
+        std::array<std::atomic<std::uint64_t>, bucket_count> buckets{};
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> sum_ns{0};
+    };
+
+    static std::array<std::array<stripe, stripe_count>, counter_count> counters;
+    static std::array<histogram, timer_count> timers;
+
+    static constexpr std::array<std::string_view, counter_count> counter_names{
+        "simql_pool_hits_total",
+        "simql_pool_misses_total",
+        "simql_pool_exhausted_total",
+        "simql_handles_allocated_total",
+        "simql_handles_freed_total",
+        "simql_executes_total",
+        "simql_fetches_total",
+        "simql_rows_fetched_total",
+        "simql_bytes_fetched_total"
+    };
+
+    // acquire_wait gets a metric of its own, the ODBC calls share one labelled by function
+    static constexpr std::array<std::string_view, timer_count> timer_names{
+        "",
+        "SQLAllocHandle",
+        "SQLPrepare",
+        "SQLExecute",
+        "SQLExecDirect",
+        "SQLFetchScroll",
+        "SQLMoreResults"
+    };
+
+    // a thread keeps the stripe it hashed to on first use
+    static std::size_t stripe_index() {
+        static thread_local std::size_t index = std::hash<std::thread::id>{}(std::this_thread::get_id()) % stripe_count;
+        return index;
+    }
+
+    static void append_histogram(std::string& text, std::string_view name, std::string_view labels, const histogram_snapshot& h) {
+        std::string separator = labels.empty() ? std::string{} : std::string{","};
+        std::uint64_t cumulative{0};
+        for (std::size_t i = 0; i + 1 < bucket_count; i++) {
+            cumulative += h.buckets[i];
+            double bound = static_cast<double>(std::uint64_t{1} << i) / 1e9;
+            text += std::format("{}_bucket{{{}{}le=\"{:g}\"}} {}\n", name, labels, separator, bound, cumulative);
+        }
+        text += std::format("{}_bucket{{{}{}le=\"+Inf\"}} {}\n", name, labels, separator, h.count);
+
+        std::string braced = labels.empty() ? std::string{} : std::format("{{{}}}", labels);
+        text += std::format("{}_sum{} {:g}\n", name, braced, static_cast<double>(h.sum_ns) / 1e9);
+        text += std::format("{}_count{} {}\n", name, braced, h.count);
+    }
+
+    void set_enabled(bool enabled) noexcept {
+        enabled_flag.store(enabled, std::memory_order_relaxed);
+    }
+
+    void add(counter c, std::uint64_t value) noexcept {
+        if (!enabled())
+            return;
+
+        counters[static_cast<std::size_t>(c)][stripe_index()].value.fetch_add(value, std::memory_order_relaxed);
+    }
+
+    void record(timer t, std::chrono::nanoseconds elapsed) noexcept {
+        if (!enabled())
+            return;
+
+        std::uint64_t ns = elapsed.count() > 0 ? static_cast<std::uint64_t>(elapsed.count()) : 0;
+        // bucket i is (2^(i-1), 2^i] to match its le bound, so exactly 2^i still lands in bucket i
+        std::size_t bucket = std::min<std::size_t>(ns > 0 ? std::bit_width(ns - 1) : 0, bucket_count - 1);
+
+        histogram& h = timers[static_cast<std::size_t>(t)];
+        h.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+        h.count.fetch_add(1, std::memory_order_relaxed);
+        h.sum_ns.fetch_add(ns, std::memory_order_relaxed);
+    }
+
+    void reset() noexcept {
+        for (auto& stripes : counters) {
+            for (stripe& s : stripes)
+                s.value.store(0, std::memory_order_relaxed);
+        }
+
+        for (histogram& h : timers) {
+            for (std::atomic<std::uint64_t>& bucket : h.buckets)
+                bucket.store(0, std::memory_order_relaxed);
+            h.count.store(0, std::memory_order_relaxed);
+            h.sum_ns.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    metrics_snapshot snapshot() {
+        metrics_snapshot snap;
+        for (std::size_t i = 0; i < counter_count; i++) {
+            for (stripe& s : counters[i])
+                snap.counters[i] += s.value.load(std::memory_order_relaxed);
+        }
+
+        for (std::size_t i = 0; i < timer_count; i++) {
+            for (std::size_t b = 0; b < bucket_count; b++)
+                snap.timers[i].buckets[b] = timers[i].buckets[b].load(std::memory_order_relaxed);
+            snap.timers[i].count = timers[i].count.load(std::memory_order_relaxed);
+            snap.timers[i].sum_ns = timers[i].sum_ns.load(std::memory_order_relaxed);
+        }
+        return snap;
+    }
+
+    std::string to_text(const metrics_snapshot& snap) {
+        std::string text;
+        for (std::size_t i = 0; i < counter_count; i++) {
+            text += std::format("# TYPE {} counter\n", counter_names[i]);
+            text += std::format("{} {}\n", counter_names[i], snap.counters[i]);
+        }
+
+        text += "# TYPE simql_acquire_wait_seconds histogram\n";
+        append_histogram(text, "simql_acquire_wait_seconds", "", snap.timers[static_cast<std::size_t>(timer::acquire_wait)]);
+
+        text += "# TYPE simql_odbc_call_seconds histogram\n";
+        for (std::size_t i = static_cast<std::size_t>(timer::odbc_alloc_handle); i < timer_count; i++)
+            append_histogram(text, "simql_odbc_call_seconds", std::format("call=\"{}\"", timer_names[i]), snap.timers[i]);
+
+        return text;
+    }
+
+    bool write_text(const std::filesystem::path& path) {
+        std::filesystem::path temporary = path;
+        temporary += ".tmp";
+
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            if (!file)
+                return false;
+
+            file << to_text(snapshot());
+            if (!file)
+                return false;
+        }
+
+        std::error_code ec;
+        std::filesystem::rename(temporary, path, ec);
+        return !ec;
+    }
+}
@@ -2,6 +2,7 @@
 #include "simql_strings.hpp"
 
 // STL stuff
+#include <exception>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -216,4 +217,15 @@ namespace simql_strings {
         return static_cast<char>(odbc);
     }
 
+
+    std::string from_exception(std::exception_ptr error) {
+        try {
+            std::rethrow_exception(error);
+        } catch (const std::exception& e) {
+            return std::string{"the callback threw: "} + e.what();
+        } catch (...) {
+            return std::string{"the callback threw an unknown exception"};
+        }
+    }
+
 }
\ No newline at end of file
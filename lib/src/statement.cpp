@@ -4,6 +4,8 @@
 #include "simql_strings.hpp"
 #include "simql_constants.hpp"
 #include "diagnostic_set.hpp"
+#include "simql_metrics.hpp"
+#include "simql_returncodes.hpp"
 
 // STL stuff
 #include <cstdint>
@@ -16,6 +18,12 @@
 #include <type_traits>
 #include <format>
 #include <concepts>
+#include <fstream>
+#include <filesystem>
+#include <cstring>
+#include <bit>
+#include <thread>
+#include <utility>
 
 // OS stuff
 #include "os_inclusions.hpp"
@@ -60,6 +68,8 @@ concept parameter_binding_typename =
 namespace simql {
 
     extern void* get_dbc_handle(database_connection& dbc) noexcept;
+    extern bool checkout_cached_statement(database_connection& dbc, std::size_t key, std::string_view sql, void*& stmt_handle, std::shared_ptr<void>& plan, simql_types::cursor_attributes& cursor);
+    extern bool checkin_cached_statement(database_connection& dbc, std::size_t key, std::string_view sql, void* stmt_handle, std::shared_ptr<void> plan, const simql_types::cursor_attributes& cursor);
 
     enum class handle_ownership : std::uint8_t {
         owns,
@@ -72,6 +82,7 @@ namespace simql {
         SQLHDBC h_dbc{SQL_NULL_HDBC};
         SQLHSTMT h_stmt{SQL_NULL_HSTMT};
         void* p_pool;
+        database_connection* p_dbc{nullptr};
 
         // diagnostics
         std::string last_error{};
@@ -84,6 +95,49 @@ namespace simql {
         SQLUSMALLINT bound_parameter_index{1};
         SQLUINTEGER rows_fetched{0};
         SQLUINTEGER current_row_index{0};
+        bool at_end{false};
+        bool columns_bound{false};
+        std::size_t attached_columns{0};
+
+        // attribute values the HSTMT currently holds, a fresh handle starts at the ODBC defaults
+        struct attribute_state {
+            std::uint32_t query_timeout{0};
+            std::uint64_t max_rows{0};
+            std::uint32_t rowset_size{1};
+            bool is_scrollable{false};
+            statement::cursor_sensitivity sensitivity{statement::cursor_sensitivity::unspecified};
+            SQLULEN paramset_size{1};
+            bool rows_fetched_bound{false};
+            bool async_enabled{false};
+        };
+        attribute_state applied{};
+
+        // state the current lease left on the HSTMT, handing it on only undoes what is set here
+        bool cursor_dirty{false};
+        bool parameters_dirty{false};
+
+        // parameters bound since the last execution, a prepare must not swap the HSTMT they are bound to
+        bool parameters_pending{false};
+
+        // prepared statement cache
+        statement::alloc_options options{};
+        std::string prepared_sql{};
+        std::size_t prepared_key{0};
+
+        // the asynchronous call in flight, polling issues it again until the driver stops returning SQL_STILL_EXECUTING
+        enum class async_step : std::uint8_t {
+            none,
+            prepare,
+            execute,
+            execute_direct,
+            fetch_first,
+            fetch_next
+        };
+        async_step pending{async_step::none};
+        std::basic_string<SQLWCHAR> pending_w_sql{};
+        std::string pending_sql{};
+        std::size_t pending_key{0};
+        bool pending_first_rowset{false};
 
         // binding for columns
         struct column_binding_struct {
@@ -110,9 +164,10 @@ namespace simql {
             SQLSMALLINT             c_type;
             SQLLEN                  buffer_length;
             std::vector<SQLLEN>     indicators;
-            statement::sql_column&  column;
+            std::uint8_t            position;
+            statement::sql_column*  column;
 
-            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_string& col) : column(col) {
+            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_string& col) : position(col.position), column(&col) {
                 if (col.is_wide) {
                     c_type              = SQL_C_WCHAR;
                     buffer_length       = (col.max_character_count + 1) * sizeof(SQLWCHAR);
@@ -126,7 +181,7 @@ namespace simql {
                 }
             }
 
-            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_character& col) : column(col) {
+            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_character& col) : position(col.position), column(&col) {
                 if (col.is_wide) {
                     c_type              = SQL_C_WCHAR;
                     buffer_length       = 2 * sizeof(SQLWCHAR);
@@ -140,88 +195,88 @@ namespace simql {
                 }
             }
 
-            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_boolean& col) : column(col) {
+            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_boolean& col) : position(col.position), column(&col) {
                 c_type                  = SQL_C_BIT;
                 buffer_length           = sizeof(SQLCHAR);
                 buffer                  = std::vector<SQLCHAR>(row_count);
                 indicators.resize(row_count);
             }
 
-            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_double& col) : column(col) {
+            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_double& col) : position(col.position), column(&col) {
                 c_type                  = SQL_C_DOUBLE;
                 buffer_length           = sizeof(SQLDOUBLE);
                 buffer                  = std::vector<SQLDOUBLE>(row_count);
                 indicators.resize(row_count);
             }
 
-            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_float& col) : column(col) {
+            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_float& col) : position(col.position), column(&col) {
                 c_type                  = SQL_C_FLOAT;
                 buffer_length           = sizeof(SQLREAL);
                 buffer                  = std::vector<SQLREAL>(row_count);
                 indicators.resize(row_count);
             }
 
-            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_int8& col) : column(col) {
+            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_int8& col) : position(col.position), column(&col) {
                 c_type                  = SQL_C_STINYINT;
                 buffer_length           = sizeof(SQLCHAR);
                 buffer                  = std::vector<SQLCHAR>(row_count);
                 indicators.resize(row_count);
             }
 
-            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_int16& col) : column(col) {
+            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_int16& col) : position(col.position), column(&col) {
                 c_type                  = SQL_C_SSHORT;
                 buffer_length           = sizeof(SQLSMALLINT);
                 buffer                  = std::vector<SQLSMALLINT>(row_count);
                 indicators.resize(row_count);
             }
 
-            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_int32& col) : column(col) {
+            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_int32& col) : position(col.position), column(&col) {
                 c_type                  = SQL_C_SLONG;
                 buffer_length           = sizeof(SQLINTEGER);
                 buffer                  = std::vector<SQLINTEGER>(row_count);
                 indicators.resize(row_count);
             }
 
-            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_int64& col) : column(col) {
+            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_int64& col) : position(col.position), column(&col) {
                 c_type                  = SQL_C_SBIGINT;
                 buffer_length           = sizeof(SQLLEN);
                 buffer                  = std::vector<SQLLEN>(row_count);
                 indicators.resize(row_count);
             }
 
-            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_guid& col) : column(col) {
+            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_guid& col) : position(col.position), column(&col) {
                 c_type                  = SQL_C_GUID;
                 buffer_length           = sizeof(simql_types::guid_struct);
                 buffer                  = std::vector<simql_types::guid_struct>(row_count);
                 indicators.resize(row_count);
             }
 
-            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_datetime& col) : column(col) {
+            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_datetime& col) : position(col.position), column(&col) {
                 c_type                  = SQL_C_TYPE_TIMESTAMP;
                 buffer_length           = sizeof(simql_types::datetime_struct);
                 buffer                  = std::vector<simql_types::datetime_struct>(row_count);
                 indicators.resize(row_count);
             }
 
-            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_date& col) : column(col) {
+            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_date& col) : position(col.position), column(&col) {
                 c_type                  = SQL_C_TYPE_DATE;
                 buffer_length           = sizeof(simql_types::date_struct);
                 buffer                  = std::vector<simql_types::date_struct>(row_count);
                 indicators.resize(row_count);
             }
 
-            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_time& col) : column(col) {
+            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_time& col) : position(col.position), column(&col) {
                 c_type                  = SQL_C_TYPE_TIME;
                 buffer_length           = sizeof(simql_types::time_struct);
                 buffer                  = std::vector<simql_types::time_struct>(row_count);
                 indicators.resize(row_count);
             }
 
-            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_blob& col) : column(col) {
+            column_binding_struct(SQLUINTEGER row_count, statement::sql_column_blob& col) : position(col.position), column(&col) {
                 c_type                  = SQL_C_BINARY;
                 buffer_length           = col.max_byte_count;
                 buffer                  = std::vector<SQLCHAR>(row_count * col.max_byte_count);
-                indicators.reserve(row_count);
+                indicators.resize(row_count);
             }
 
             SQLPOINTER ptr() {
@@ -256,7 +311,10 @@ namespace simql {
             }
 
             void update(SQLUINTEGER row_index) {
-                column.value = std::visit([&](auto& x) -> simql_types::sql_value {
+                if (!column)
+                    return;
+
+                column->value = std::visit([&](auto& x) -> simql_types::sql_value {
                     using T = std::decay_t<decltype(x)>;
 
                     if (indicators[row_index] == SQL_NULL_DATA)
@@ -359,6 +417,11 @@ namespace simql {
         };
         std::deque<column_binding_struct> column_bindings;
 
+        // what a cached HSTMT carries besides the prepared SQL, the deque keeps the bound buffers in place
+        struct prepared_plan {
+            std::deque<column_binding_struct> column_bindings;
+        };
+
         // binding for parameters
         struct parameter_binding_struct {
         private:
@@ -900,7 +963,253 @@ namespace simql {
             }
 
         };
-        std::map<std::string, parameter_binding_struct> parameter_bindings;
+        std::map<std::uint8_t, parameter_binding_struct> parameter_bindings;
+
+        // binding for streamed parameters, the address of each element is the SQLParamData token
+        struct stream_binding_struct {
+            statement::sql_parameter_stream& parameter;
+            SQLLEN indicator;
+            stream_binding_struct(statement::sql_parameter_stream& param) : parameter(param) {
+                indicator = param.total_length >= 0 ? SQL_LEN_DATA_AT_EXEC(param.total_length) : SQL_DATA_AT_EXEC;
+            }
+        };
+        std::deque<stream_binding_struct> stream_bindings;
+        std::vector<std::uint8_t> stream_buffer;
+        bool stream_failed{false};
+
+        // binding for column-wise parameter arrays
+        struct batch_binding_struct {
+            simql_types::sql_data_type  type;
+            SQLSMALLINT                 c_data_type;
+            SQLSMALLINT                 sql_data_type;
+            SQLULEN                     column_size{0};
+            SQLSMALLINT                 decimal_digits{0};
+            SQLLEN                      element_length;
+            std::vector<std::uint8_t>   buffer;
+            std::vector<SQLLEN>         indicators;
+
+            batch_binding_struct(const statement::sql_parameter_column& column, std::size_t capacity) : type(column.type) {
+                switch (column.type) {
+                case simql_types::sql_data_type::string:
+                    c_data_type = SQL_C_CHAR;
+                    sql_data_type = SQL_VARCHAR;
+                    column_size = column.max_size;
+                    element_length = (column.max_size + 1) * sizeof(SQLCHAR);
+                    break;
+                case simql_types::sql_data_type::wide_string:
+                    c_data_type = SQL_C_WCHAR;
+                    sql_data_type = SQL_WVARCHAR;
+                    column_size = column.max_size;
+                    element_length = (column.max_size + 1) * sizeof(SQLWCHAR);
+                    break;
+                case simql_types::sql_data_type::character:
+                    c_data_type = SQL_C_CHAR;
+                    sql_data_type = SQL_CHAR;
+                    column_size = 1;
+                    element_length = 2 * sizeof(SQLCHAR);
+                    break;
+                case simql_types::sql_data_type::boolean:
+                    c_data_type = SQL_C_BIT;
+                    sql_data_type = SQL_BIT;
+                    element_length = sizeof(SQLCHAR);
+                    break;
+                case simql_types::sql_data_type::float64:
+                    c_data_type = SQL_C_DOUBLE;
+                    sql_data_type = SQL_DOUBLE;
+                    element_length = sizeof(SQLDOUBLE);
+                    break;
+                case simql_types::sql_data_type::float32:
+                    c_data_type = SQL_C_FLOAT;
+                    sql_data_type = SQL_REAL;
+                    element_length = sizeof(SQLREAL);
+                    break;
+                case simql_types::sql_data_type::int8:
+                    c_data_type = SQL_C_STINYINT;
+                    sql_data_type = SQL_TINYINT;
+                    element_length = sizeof(SQLCHAR);
+                    break;
+                case simql_types::sql_data_type::int16:
+                    c_data_type = SQL_C_SSHORT;
+                    sql_data_type = SQL_SMALLINT;
+                    element_length = sizeof(SQLSMALLINT);
+                    break;
+                case simql_types::sql_data_type::int32:
+                    c_data_type = SQL_C_SLONG;
+                    sql_data_type = SQL_INTEGER;
+                    element_length = sizeof(SQLINTEGER);
+                    break;
+                case simql_types::sql_data_type::int64:
+                    c_data_type = SQL_C_SBIGINT;
+                    sql_data_type = SQL_BIGINT;
+                    element_length = sizeof(std::int64_t);
+                    break;
+                case simql_types::sql_data_type::guid:
+                    c_data_type = SQL_C_GUID;
+                    sql_data_type = SQL_GUID;
+                    element_length = sizeof(simql_types::guid_struct);
+                    break;
+                case simql_types::sql_data_type::datetime:
+                    c_data_type = SQL_C_TYPE_TIMESTAMP;
+                    sql_data_type = SQL_TYPE_TIMESTAMP;
+                    column_size = 29;
+                    decimal_digits = 9;
+                    element_length = sizeof(simql_types::datetime_struct);
+                    break;
+                case simql_types::sql_data_type::date:
+                    c_data_type = SQL_C_TYPE_DATE;
+                    sql_data_type = SQL_TYPE_DATE;
+                    column_size = 10;
+                    element_length = sizeof(simql_types::date_struct);
+                    break;
+                case simql_types::sql_data_type::time:
+                    c_data_type = SQL_C_TYPE_TIME;
+                    sql_data_type = SQL_TYPE_TIME;
+                    column_size = 8;
+                    element_length = sizeof(simql_types::time_struct);
+                    break;
+                case simql_types::sql_data_type::blob:
+                    c_data_type = SQL_C_BINARY;
+                    sql_data_type = SQL_VARBINARY;
+                    column_size = column.max_size;
+                    element_length = column.max_size;
+                    break;
+                }
+
+                buffer.resize(capacity * element_length);
+                indicators.resize(capacity);
+            }
+
+            template<typename T>
+            void write_value(std::size_t row, const T& value) {
+                std::memcpy(buffer.data() + row * element_length, &value, sizeof(T));
+                indicators[row] = 0;
+            }
+
+            // get<T>() falls back to a default on a mismatch, so the value has to hold the column's type exactly
+            bool accepts(const simql_types::sql_value& value) const {
+                if (value.is_null())
+                    return true;
+
+                switch (type) {
+                case simql_types::sql_data_type::string:
+                case simql_types::sql_data_type::wide_string:
+                    return value.holds<std::string>();
+                case simql_types::sql_data_type::character:
+                    return value.holds<char>();
+                case simql_types::sql_data_type::boolean:
+                    return value.holds<bool>();
+                case simql_types::sql_data_type::float64:
+                    return value.holds<double>();
+                case simql_types::sql_data_type::float32:
+                    return value.holds<float>();
+                case simql_types::sql_data_type::int8:
+                    return value.holds<std::int8_t>();
+                case simql_types::sql_data_type::int16:
+                    return value.holds<std::int16_t>();
+                case simql_types::sql_data_type::int32:
+                    return value.holds<std::int32_t>();
+                case simql_types::sql_data_type::int64:
+                    return value.holds<std::int64_t>();
+                case simql_types::sql_data_type::guid:
+                    return value.holds<simql_types::guid_struct>();
+                case simql_types::sql_data_type::datetime:
+                    return value.holds<simql_types::datetime_struct>();
+                case simql_types::sql_data_type::date:
+                    return value.holds<simql_types::date_struct>();
+                case simql_types::sql_data_type::time:
+                    return value.holds<simql_types::time_struct>();
+                case simql_types::sql_data_type::blob:
+                    return value.holds<std::vector<std::uint8_t>>();
+                }
+                return false;
+            }
+
+            // strings and blobs are truncated to the declared size
+            void write(std::size_t row, const simql_types::sql_value& value) {
+                if (value.is_null()) {
+                    indicators[row] = SQL_NULL_DATA;
+                    return;
+                }
+
+                std::uint8_t* p_element = buffer.data() + row * element_length;
+                switch (type) {
+                case simql_types::sql_data_type::string: {
+                    auto str = simql_strings::to_odbc_n(value.get<std::string>());
+                    std::size_t length = std::min<std::size_t>(str.size(), column_size);
+                    std::memcpy(p_element, str.data(), length * sizeof(SQLCHAR));
+                    reinterpret_cast<SQLCHAR*>(p_element)[length] = 0;
+                    indicators[row] = static_cast<SQLLEN>(length * sizeof(SQLCHAR));
+                    break;
+                }
+                case simql_types::sql_data_type::wide_string: {
+                    auto str = simql_strings::to_odbc_w(value.get<std::string>());
+                    std::size_t length = std::min<std::size_t>(str.size(), column_size);
+                    std::memcpy(p_element, str.data(), length * sizeof(SQLWCHAR));
+                    reinterpret_cast<SQLWCHAR*>(p_element)[length] = 0;
+                    indicators[row] = static_cast<SQLLEN>(length * sizeof(SQLWCHAR));
+                    break;
+                }
+                case simql_types::sql_data_type::character:
+                    p_element[0] = simql_strings::to_odbc_char_n(value.get<char>());
+                    p_element[1] = 0;
+                    indicators[row] = sizeof(SQLCHAR);
+                    break;
+                case simql_types::sql_data_type::boolean:
+                    write_value(row, static_cast<SQLCHAR>(value.get<bool>() ? 1 : 0));
+                    break;
+                case simql_types::sql_data_type::float64:
+                    write_value(row, static_cast<SQLDOUBLE>(value.get<double>()));
+                    break;
+                case simql_types::sql_data_type::float32:
+                    write_value(row, static_cast<SQLREAL>(value.get<float>()));
+                    break;
+                case simql_types::sql_data_type::int8:
+                    write_value(row, value.get<std::int8_t>());
+                    break;
+                case simql_types::sql_data_type::int16:
+                    write_value(row, static_cast<SQLSMALLINT>(value.get<std::int16_t>()));
+                    break;
+                case simql_types::sql_data_type::int32:
+                    write_value(row, static_cast<SQLINTEGER>(value.get<std::int32_t>()));
+                    break;
+                case simql_types::sql_data_type::int64:
+                    write_value(row, value.get<std::int64_t>());
+                    break;
+                case simql_types::sql_data_type::guid:
+                    write_value(row, value.get<simql_types::guid_struct>());
+                    break;
+                case simql_types::sql_data_type::datetime:
+                    write_value(row, value.get<simql_types::datetime_struct>());
+                    break;
+                case simql_types::sql_data_type::date:
+                    write_value(row, value.get<simql_types::date_struct>());
+                    break;
+                case simql_types::sql_data_type::time:
+                    write_value(row, value.get<simql_types::time_struct>());
+                    break;
+                case simql_types::sql_data_type::blob: {
+                    auto bytes = value.get<std::vector<std::uint8_t>>();
+                    std::size_t length = std::min<std::size_t>(bytes.size(), column_size);
+                    std::memcpy(p_element, bytes.data(), length);
+                    indicators[row] = static_cast<SQLLEN>(length);
+                    break;
+                }
+                }
+            }
+        };
+        std::vector<batch_binding_struct> batch_bindings;
+        std::vector<statement::sql_parameter_column> batch_layout;
+        std::size_t batch_capacity{0};
+        SQLULEN batch_rows_processed{0};
+
+        // binding for compile-time typed parameters, the plan pointer identifies the argument type at that position
+        struct typed_binding_struct {
+            const simql_binding::parameter_plan*    plan{nullptr};
+            SQLPOINTER                              data{nullptr};
+            SQLULEN                                 column_size{0};
+            SQLLEN                                  indicator{0};
+        };
+        std::vector<typed_binding_struct> typed_bindings;
 
         // --------------------------------------------------
         // LIFECYCLE
@@ -908,104 +1217,136 @@ namespace simql {
 
         handle() = default;
 
-        explicit handle(database_connection& dbc, const statement::alloc_options& options) {
+        explicit handle(database_connection& dbc, const statement::alloc_options& options) : p_dbc(&dbc), options(options) {
             ownership = handle_ownership::owns;
+            h_dbc = static_cast<SQLHDBC>(get_dbc_handle(dbc));
+            is_valid = allocate_handle();
+        }
+
+        // a pooled HSTMT was configured with the pool's options and comes with the cursor attributes it ended up with
+        handle(void* stmt_handle, database_connection* conn, void* pool, const statement::alloc_options& pool_options, const simql_types::cursor_attributes& cursor, std::string_view sql, std::shared_ptr<void> plan) : p_dbc(conn), options(pool_options) {
+            h_dbc = conn ? static_cast<SQLHDBC>(get_dbc_handle(*conn)) : SQL_NULL_HDBC;
+            h_stmt = static_cast<SQLHSTMT>(stmt_handle);
+            ownership = handle_ownership::borrows;
+            p_pool = pool;
+
+            if (!h_stmt) {
+                last_error = std::string{"no statement handle is available in the pool"};
+                is_valid = false;
+                return;
+            }
+
+            assume_configured(cursor);
+            if (sql.empty())
+                return;
+
+            // a pool hit arrives prepared with its columns bound, a cold handle is prepared here
+            if (plan) {
+                adopt_plan(std::move(plan));
+                prepared_sql = std::string(sql);
+            } else {
+                is_valid = prepare(sql);
+            }
+        }
+
+        ~handle() {
+            if (h_stmt) {
+                abandon_async();
+                switch (ownership) {
+                case handle_ownership::owns:
+                    release_handle();
+                    break;
+                case handle_ownership::borrows:
+                    clear_execution_state();
+                    if (!column_bindings.empty())
+                        SQLFreeStmt(h_stmt, SQL_UNBIND);
+                    break;
+                }
+                h_stmt = SQL_NULL_HSTMT;
+            }
+        }
+
+        bool allocate_handle() {
 
             // allocate the handle
-            h_dbc = static_cast<SQLHDBC>(get_dbc_handle(dbc));
-            switch (SQLAllocHandle(SQL_HANDLE_STMT, h_dbc, &h_stmt)) {
+            applied = attribute_state{};
+            switch (simql_metrics::timed(simql_metrics::timer::odbc_alloc_handle, [&]() { return SQLAllocHandle(SQL_HANDLE_STMT, h_dbc, &h_stmt); })) {
             case SQL_SUCCESS:
+                simql_metrics::add(simql_metrics::counter::handles_allocated);
                 break;
             case SQL_SUCCESS_WITH_INFO:
+                simql_metrics::add(simql_metrics::counter::handles_allocated);
                 diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::string{"SQLAllocHandle(SQL_HANDLE_STMT) -> SUCCESS_WITH_INFO"});
                 break;
             case SQL_INVALID_HANDLE:
                 last_error = std::string{"could not allocate the statement handle: invalid handle"};
                 diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::string{"SQLAllocHandle(SQL_HANDLE_STMT) -> INVALID_HANDLE"});
-                is_valid = false;
-                return;
+                return false;
             default:
                 last_error = std::string{"could not allocate the statement handle: generic error"};
                 diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::string{"SQLAllocHandle(SQL_HANDLE_STMT) -> ERROR"});
-                is_valid = false;
-                return;
+                return false;
             }
 
             // set query timeout
-            is_valid = set_query_timeout(options.query_timeout);
-            if (!is_valid)
-                return;
+            if (!set_query_timeout(options.query_timeout))
+                return false;
 
             // set max rows
-            is_valid = set_max_rows(options.max_rows);
-            if (!is_valid)
-                return;
+            if (!set_max_rows(options.max_rows))
+                return false;
 
             // set rowset size
-            is_valid = set_rowset_size(options.rowset_size);
-            if (!is_valid)
-                return;
+            if (!set_rowset_size(options.rowset_size))
+                return false;
 
             // set the cursor scrollability
-            is_valid = set_scrollable(options.is_scrollable);
-            if (!is_valid)
-                return;
+            if (!set_scrollable(options.is_scrollable))
+                return false;
 
             // set cursor sensitivity
-            is_valid = set_cursor_sensitivity(options.sensitivity);
-            if (!is_valid)
-                return;
+            if (!set_cursor_sensitivity(options.sensitivity))
+                return false;
 
+            return true;
         }
 
-        handle(void* stmt_handle, database_connection& conn, void* pool) noexcept {
-            h_dbc = static_cast<SQLHDBC>(get_dbc_handle(conn));
-            h_stmt = static_cast<SQLHSTMT>(stmt_handle);
-            ownership = handle_ownership::borrows;
-            p_pool = pool;
+        void reset() {
+            SQLCloseCursor(h_stmt);
+            SQLFreeStmt(h_stmt, SQL_RESET_PARAMS);
+            SQLFreeStmt(h_stmt, SQL_UNBIND);
+            columns_bound = false;
+            cursor_dirty = false;
+            parameters_dirty = false;
+        }
 
-            SQLULEN is_scrollable;
-            switch (SQLGetStmtAttrW(h_stmt, SQL_ATTR_CURSOR_SCROLLABLE, &is_scrollable, SQL_IS_INTEGER, nullptr)) {
-            case SQL_SUCCESS:
-                cursor_is_scrollable = is_scrollable == SQL_SCROLLABLE;
-                break;
-            case SQL_SUCCESS_WITH_INFO:
-                cursor_is_scrollable = is_scrollable == SQL_SCROLLABLE;
-                diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLGetStmtAttr(SQL_ATTR_CURSOR_SCROLLABLE) -> SUCCESS_WITH_INFO"});
-                break;
-            case SQL_INVALID_HANDLE:
-                last_error = std::string{"could not determine the cursor scrolling status: invalid handle"};
-                diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::string{"SQLGetStmtAttr(SQL_ATTR_CURSOR_SCROLLABLE) -> INVALID_HANDLE"});
-                is_valid = false;
-                break;
-            default:
-                last_error = std::string{"could not determine the cursor scrolling status: generic error"};
-                diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLGetStmtAttr(SQL_ATTR_CURSOR_SCROLLABLE) -> ERROR"});
-                is_valid = false;
-                break;
-            }
+        // a pooled or cached HSTMT was configured with the options, the cursor attributes the driver may have
+        // substituted were read back when it was configured and travel with it, so nothing is asked of the driver
+        void assume_configured(const simql_types::cursor_attributes& cursor) {
+            applied = attribute_state{};
+            applied.query_timeout = options.query_timeout;
+            applied.max_rows = options.max_rows;
+            applied.rowset_size = cursor.rowset_size;
+            applied.is_scrollable = cursor.is_scrollable;
+            applied.sensitivity = options.sensitivity;
+            cursor_is_scrollable = cursor.is_scrollable;
         }
 
-        ~handle() {
-            if (h_stmt) {
-                switch (ownership) {
-                case handle_ownership::owns:
-                    SQLFreeHandle(SQL_HANDLE_STMT, h_stmt);
-                    break;
-                case handle_ownership::borrows:
-                    SQLFreeStmt(h_stmt, SQL_CLOSE);
-                    SQLFreeStmt(h_stmt, SQL_RESET_PARAMS);
-                    SQLFreeStmt(h_stmt, SQL_UNBIND);
-                    break;
-                }
-                h_stmt = SQL_NULL_HSTMT;
-            }
+        simql_types::cursor_attributes cursor_state() const {
+            return simql_types::cursor_attributes{applied.rowset_size, applied.is_scrollable};
         }
 
-        void reset() {
-            SQLCloseCursor(h_stmt);
-            SQLFreeStmt(h_stmt, SQL_RESET_PARAMS);
-            SQLFreeStmt(h_stmt, SQL_UNBIND);
+        // a driver that cannot honour a value substitutes one it supports and returns 01S02, the handle then holds that one
+        void read_back_cursor_attributes() {
+            SQLULEN rowset_size{0};
+            if (SQL_SUCCEEDED(SQLGetStmtAttrW(h_stmt, SQL_ATTR_ROW_ARRAY_SIZE, &rowset_size, SQL_IS_UINTEGER, nullptr)) && rowset_size > 0)
+                applied.rowset_size = static_cast<std::uint32_t>(rowset_size);
+
+            SQLULEN scrollable{SQL_NONSCROLLABLE};
+            if (SQL_SUCCEEDED(SQLGetStmtAttrW(h_stmt, SQL_ATTR_CURSOR_SCROLLABLE, &scrollable, SQL_IS_UINTEGER, nullptr))) {
+                applied.is_scrollable = scrollable == SQL_SCROLLABLE;
+                cursor_is_scrollable = applied.is_scrollable;
+            }
         }
 
         // --------------------------------------------------
@@ -1013,11 +1354,16 @@ namespace simql {
         // --------------------------------------------------
 
         bool set_query_timeout(std::uint32_t timeout) {
+            if (applied.query_timeout == timeout)
+                return true;
+
             SQLPOINTER p_query_timeout = reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(timeout));
             switch (SQLSetStmtAttrW(h_stmt, SQL_ATTR_QUERY_TIMEOUT, p_query_timeout, SQL_IS_INTEGER)) {
             case SQL_SUCCESS:
+                applied.query_timeout = timeout;
                 return true;
             case SQL_SUCCESS_WITH_INFO:
+                applied.query_timeout = timeout;
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLSetStmtAttr(SQL_ATTR_QUERY_TIMEOUT) -> SUCCESS_WITH_INFO"});
                 return true;
             case SQL_INVALID_HANDLE:
@@ -1032,11 +1378,16 @@ namespace simql {
         }
 
         bool set_max_rows(std::uint64_t max_rows) {
+            if (applied.max_rows == max_rows)
+                return true;
+
             SQLPOINTER p_max_rows = reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(max_rows));
             switch (SQLSetStmtAttrW(h_stmt, SQL_ATTR_MAX_ROWS, p_max_rows, SQL_IS_INTEGER)) {
             case SQL_SUCCESS:
+                applied.max_rows = max_rows;
                 return true;
             case SQL_SUCCESS_WITH_INFO:
+                applied.max_rows = max_rows;
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLSetStmtAttr(SQL_ATTR_MAX_ROWS) -> SUCCESS_WITH_INFO"});
                 return true;
             case SQL_INVALID_HANDLE:
@@ -1057,12 +1408,18 @@ namespace simql {
                 return false;
             }
 
+            if (applied.rowset_size == rowset_size)
+                return true;
+
             SQLPOINTER p_rowset_size = reinterpret_cast<SQLPOINTER>(static_cast<SQLUINTEGER>(rowset_size));
             switch (SQLSetStmtAttrW(h_stmt, SQL_ATTR_ROW_ARRAY_SIZE, p_rowset_size, SQL_IS_INTEGER)) {
             case SQL_SUCCESS:
+                applied.rowset_size = rowset_size;
                 return true;
             case SQL_SUCCESS_WITH_INFO:
+                applied.rowset_size = rowset_size;
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLSetStmtAttr(SQL_ATTR_ROW_ARRAY_SIZE) -> SUCCESS_WITH_INFO"});
+                read_back_cursor_attributes();
                 return true;
             case SQL_INVALID_HANDLE:
                 last_error = std::string{"could not set the rowset size: invalid handle"};
@@ -1076,14 +1433,22 @@ namespace simql {
         }
 
         bool set_scrollable(bool is_scrollable) {
+            if (applied.is_scrollable == is_scrollable) {
+                cursor_is_scrollable = is_scrollable;
+                return true;
+            }
+
             SQLPOINTER p_is_scrollable = is_scrollable ? reinterpret_cast<SQLPOINTER>(SQL_SCROLLABLE) : reinterpret_cast<SQLPOINTER>(SQL_NONSCROLLABLE);
             switch (SQLSetStmtAttrW(h_stmt, SQL_ATTR_CURSOR_SCROLLABLE, p_is_scrollable, SQL_IS_INTEGER)) {
             case SQL_SUCCESS:
                 cursor_is_scrollable = is_scrollable;
+                applied.is_scrollable = is_scrollable;
                 return true;
             case SQL_SUCCESS_WITH_INFO:
                 cursor_is_scrollable = is_scrollable;
+                applied.is_scrollable = is_scrollable;
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLSetStmtAttr(SQL_ATTR_CURSOR_SCROLLABLE) -> SUCCESS_WITH_INFO"});
+                read_back_cursor_attributes();
                 return true;
             case SQL_INVALID_HANDLE:
                 last_error = std::string{"could not set the rowset size: invalid handle"};
@@ -1097,6 +1462,9 @@ namespace simql {
         }
 
         bool set_cursor_sensitivity(statement::cursor_sensitivity cursor) {
+            if (applied.sensitivity == cursor)
+                return true;
+
             SQLPOINTER p_cursor_sensitivity;
             switch (cursor) {
             case statement::cursor_sensitivity::unspecified:
@@ -1112,8 +1480,10 @@ namespace simql {
 
             switch (SQLSetStmtAttrW(h_stmt, SQL_ATTR_CURSOR_SENSITIVITY, p_cursor_sensitivity, SQL_IS_INTEGER)) {
             case SQL_SUCCESS:
+                applied.sensitivity = cursor;
                 return true;
             case SQL_SUCCESS_WITH_INFO:
+                applied.sensitivity = cursor;
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLSetStmtAttr(SQL_ATTR_CURSOR_SENSITIVITY) -> SUCCESS_WITH_INFO"});
                 return true;
             case SQL_INVALID_HANDLE:
@@ -1128,10 +1498,15 @@ namespace simql {
         }
 
         bool update_fetched_row_count() {
+            if (applied.rows_fetched_bound)
+                return true;
+
             switch (SQLSetStmtAttrW(h_stmt, SQL_ATTR_ROWS_FETCHED_PTR, &rows_fetched, SQL_IS_INTEGER)) {
             case SQL_SUCCESS:
+                applied.rows_fetched_bound = true;
                 return true;
             case SQL_SUCCESS_WITH_INFO:
+                applied.rows_fetched_bound = true;
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLSetStmtAttr(SQL_ATTR_FETCHED_PTR) -> SUCCESS_WITH_INFO"});
                 return true;
             case SQL_INVALID_HANDLE:
@@ -1145,17 +1520,211 @@ namespace simql {
             }
         }
 
+        // a driver refusing the attribute leaves last_error alone, its calls simply run synchronously
+        bool set_async(bool enabled) {
+            if (applied.async_enabled == enabled)
+                return true;
+
+            SQLPOINTER p_async = reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(enabled ? SQL_ASYNC_ENABLE_ON : SQL_ASYNC_ENABLE_OFF));
+            switch (SQLSetStmtAttrW(h_stmt, SQL_ATTR_ASYNC_ENABLE, p_async, SQL_IS_UINTEGER)) {
+            case SQL_SUCCESS:
+                applied.async_enabled = enabled;
+                return true;
+            case SQL_SUCCESS_WITH_INFO:
+                applied.async_enabled = enabled;
+                diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLSetStmtAttr(SQL_ATTR_ASYNC_ENABLE) -> SUCCESS_WITH_INFO"});
+                return true;
+            case SQL_INVALID_HANDLE:
+                diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::string{"SQLSetStmtAttr(SQL_ATTR_ASYNC_ENABLE) -> INVALID_HANDLE"});
+                return false;
+            default:
+                diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLSetStmtAttr(SQL_ATTR_ASYNC_ENABLE) -> ERROR"});
+                return false;
+            }
+        }
+
+        // --------------------------------------------------
+        // PREPARED STATEMENT CACHE
+        // --------------------------------------------------
+
+        // the statement attributes are part of the key since a cached HSTMT keeps them
+        std::size_t cache_key(std::string_view sql) const {
+            std::size_t key = std::hash<std::string_view>{}(sql);
+            auto combine = [&key](std::size_t value) {
+                key ^= value + static_cast<std::size_t>(0x9e3779b97f4a7c15ull) + (key << 6) + (key >> 2);
+            };
+            combine(options.query_timeout);
+            combine(static_cast<std::size_t>(options.max_rows));
+            combine(options.rowset_size);
+            combine(options.is_scrollable);
+            combine(static_cast<std::size_t>(options.sensitivity));
+            return key;
+        }
+
+        // drops everything tied to this handle's memory so the HSTMT can be handed on, skipping whatever the lease never touched
+        void clear_execution_state() {
+            abandon_async();
+            if (cursor_dirty)
+                SQLFreeStmt(h_stmt, SQL_CLOSE);
+
+            if (parameters_dirty)
+                SQLFreeStmt(h_stmt, SQL_RESET_PARAMS);
+
+            if (applied.rows_fetched_bound) {
+                SQLSetStmtAttrW(h_stmt, SQL_ATTR_ROWS_FETCHED_PTR, nullptr, SQL_IS_POINTER);
+                applied.rows_fetched_bound = false;
+            }
+
+            if (batch_capacity > 0) {
+                SQLSetStmtAttrW(h_stmt, SQL_ATTR_PARAMS_PROCESSED_PTR, nullptr, SQL_IS_POINTER);
+                set_paramset_size(1);
+            }
+
+            cursor_dirty = false;
+            parameters_dirty = false;
+            parameters_pending = false;
+
+            parameter_bindings.clear();
+            stream_bindings.clear();
+            typed_bindings.clear();
+            batch_bindings.clear();
+            batch_layout.clear();
+            batch_capacity = 0;
+            rows_fetched = 0;
+            current_row_index = 0;
+        }
+
+        // the columns belong to the previous user, the buffers stay bound to the driver until add_column reattaches them
+        void detach_columns() {
+            for (column_binding_struct& binding : column_bindings)
+                binding.column = nullptr;
+            attached_columns = 0;
+        }
+
+        // hands the column bindings over with the HSTMT, they stay bound to the driver
+        std::shared_ptr<prepared_plan> take_plan() {
+            detach_columns();
+
+            auto plan = std::make_shared<prepared_plan>();
+            plan->column_bindings = std::move(column_bindings);
+            column_bindings.clear();
+            columns_bound = false;
+            return plan;
+        }
+
+        void adopt_plan(std::shared_ptr<void> plan) {
+            column_bindings.clear();
+            if (plan)
+                column_bindings = std::move(std::static_pointer_cast<prepared_plan>(plan)->column_bindings);
+
+            columns_bound = !column_bindings.empty();
+            attached_columns = 0;
+        }
+
+        // returns a prepared HSTMT to the connection cache along with its column bindings, or frees it
+        void release_handle() {
+            if (!h_stmt)
+                return;
+
+            abandon_async();
+
+            if (ownership == handle_ownership::owns && p_dbc && !prepared_sql.empty()) {
+                clear_execution_state();
+                if (checkin_cached_statement(*p_dbc, prepared_key, prepared_sql, reinterpret_cast<void*>(h_stmt), take_plan(), cursor_state())) {
+                    h_stmt = SQL_NULL_HSTMT;
+                    prepared_sql.clear();
+                    return;
+                }
+            }
+
+            SQLFreeHandle(SQL_HANDLE_STMT, h_stmt);
+            simql_metrics::add(simql_metrics::counter::handles_freed);
+            h_stmt = SQL_NULL_HSTMT;
+            prepared_sql.clear();
+            column_bindings.clear();
+            columns_bound = false;
+            attached_columns = 0;
+        }
+
+        // returns a borrowed HSTMT to its pool, a prepared one keeps its SQL and column bindings
+        SQLHSTMT detach(std::string& sql, std::shared_ptr<void>& plan) {
+            if (!h_stmt)
+                return SQL_NULL_HSTMT;
+
+            clear_execution_state();
+            if (!prepared_sql.empty()) {
+                plan = take_plan();
+                sql = std::move(prepared_sql);
+            } else {
+                if (!column_bindings.empty())
+                    SQLFreeStmt(h_stmt, SQL_UNBIND);
+                column_bindings.clear();
+                columns_bound = false;
+                attached_columns = 0;
+            }
+            prepared_sql.clear();
+
+            SQLHSTMT h = h_stmt;
+            h_stmt = SQL_NULL_HSTMT;
+            return h;
+        }
+
+        // swaps the current HSTMT for a cached one that already holds the prepared SQL
+        bool prepare_from_cache(std::string_view sql, std::size_t key) {
+            void* cached_stmt{nullptr};
+            std::shared_ptr<void> cached_plan;
+            simql_types::cursor_attributes cursor;
+            if (!checkout_cached_statement(*p_dbc, key, sql, cached_stmt, cached_plan, cursor))
+                return false;
+
+            release_handle();
+            h_stmt = static_cast<SQLHSTMT>(cached_stmt);
+            assume_configured(cursor);
+            adopt_plan(std::move(cached_plan));
+            prepared_sql = std::string(sql);
+            prepared_key = key;
+            return true;
+        }
+
         // --------------------------------------------------
         // EXECUTION
         // --------------------------------------------------
 
-        bool prepare(std::string_view sql) {
-            std::basic_string<SQLWCHAR> w_sql = simql_strings::to_odbc_w(sql);
-            switch (SQLPrepareW(h_stmt, w_sql.data(), SQL_NTS)) {
+        // takes a cached HSTMT for the SQL when there is one, otherwise leaves the handle ready to prepare it
+        bool ready_for_prepare(std::string_view sql, std::size_t key, bool& cached) {
+            cached = false;
+
+            // parameters bound ahead of prepare() live on this HSTMT, so it is prepared in place rather than swapped
+            if (ownership == handle_ownership::owns && p_dbc && !parameters_pending) {
+                if (prepare_from_cache(sql, key)) {
+                    cached = true;
+                    return true;
+                }
+
+                // keep the previously prepared SQL cached rather than preparing over it
+                if (!prepared_sql.empty() && p_dbc->statement_cache().capacity > 0) {
+                    release_handle();
+                    if (!allocate_handle()) {
+                        is_valid = false;
+                        return false;
+                    }
+                }
+            }
+
+            prepared_sql.clear();
+            return true;
+        }
+
+        bool finish_prepare(SQLRETURN rc, std::string_view sql, std::size_t key) {
+            switch (rc) {
             case SQL_SUCCESS:
+                prepared_sql = std::string(sql);
+                prepared_key = key;
                 return true;
             case SQL_SUCCESS_WITH_INFO:
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLPrepare() -> SUCCESS_WITH_INFO"});
+                prepared_sql = std::string(sql);
+                prepared_key = key;
                 return true;
             case SQL_INVALID_HANDLE:
                 last_error = std::string{"could not prepare the provided SQL: invalid handle"};
@@ -1168,95 +1737,637 @@ namespace simql {
             }
         }
 
+        bool prepare(std::string_view sql) {
+            std::size_t key = cache_key(sql);
+            bool cached{false};
+            if (!ready_for_prepare(sql, key, cached))
+                return false;
+
+            if (cached)
+                return true;
+
+            std::basic_string<SQLWCHAR> w_sql = simql_strings::to_odbc_w(sql);
+            return finish_prepare(simql_metrics::timed(simql_metrics::timer::odbc_prepare, [&]() { return SQLPrepareW(h_stmt, w_sql.data(), SQL_NTS); }), sql, key);
+        }
+
         bool execute() {
-            switch (SQLExecute(h_stmt)) {
+            simql_metrics::add(simql_metrics::counter::executes);
+            cursor_dirty = true;
+            SQLRETURN rc = simql_metrics::timed(simql_metrics::timer::odbc_execute, [&]() { return SQLExecute(h_stmt); });
+            if (rc == SQL_NEED_DATA)
+                rc = put_stream_data();
+
+            return check_execute(rc) && open_results();
+        }
+
+        bool check_execute(SQLRETURN rc) {
+            parameters_pending = false;
+            switch (rc) {
             case SQL_SUCCESS:
-                break;
+                return true;
             case SQL_SUCCESS_WITH_INFO:
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLExecute() -> SUCCESS_WITH_INFO"});
-                break;
+                return true;
             case SQL_INVALID_HANDLE:
                 last_error = std::string{"could not execute the prepared SQL: invalid handle"};
                 diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::string{"SQLExecute() -> INVALID_HANDLE"});
                 return false;
             default:
-                last_error = std::string{"could not execute the prepared SQL: generic error"};
+                if (!std::exchange(stream_failed, false))
+                    last_error = std::string{"could not execute the prepared SQL: generic error"};
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLExecute() -> ERROR"});
                 return false;
             }
+        }
 
+        // binds and fetches the first rowset when the execution produced a result set
+        bool open_results() {
             SQLSMALLINT column_count;
             if (!SQL_SUCCEEDED(SQLNumResultCols(h_stmt, &column_count))) {
                 last_error = std::string{"could not determine if the SQL query returned one or more result sets"};
                 return false;
             }
 
-            if (column_count >= 1) {
+            // columns defined only after the execution are bound by the first navigation, which fetches the first rowset
+            at_end = false;
+            rows_fetched = 0;
+            current_row_index = 0;
+            if (column_count >= 1 && !column_bindings.empty()) {
 
                 if (!bind_columns())
                     return false;
 
+                // an empty result set is still a successful execution
                 if (cursor_is_scrollable) {
-                    if (!fetch_first())
+                    if (!fetch_first() && !at_end)
                         return false;
 
                 } else {
-                    if (!fetch_next())
+                    if (!fetch_next() && !at_end)
                         return false;
 
                 }
+                load_row();
             }
 
             return true;
         }
 
+        // runs on another thread than the call it interrupts, so it leaves last_error and the diagnostics alone
+        bool cancel() {
+            if (!h_stmt)
+                return false;
+
+            return SQL_SUCCEEDED(SQLCancel(h_stmt));
+        }
+
         bool execute_direct(std::string_view sql) {
+
+            // direct execution discards whatever was prepared on the handle
+            prepared_sql.clear();
             std::basic_string<SQLWCHAR> w_sql = simql_strings::to_odbc_w(sql);
-            switch (SQLExecDirectW(h_stmt, w_sql.data(), SQL_NTS)) {
+            simql_metrics::add(simql_metrics::counter::executes);
+            cursor_dirty = true;
+            SQLRETURN rc = simql_metrics::timed(simql_metrics::timer::odbc_exec_direct, [&]() { return SQLExecDirectW(h_stmt, w_sql.data(), SQL_NTS); });
+            if (rc == SQL_NEED_DATA)
+                rc = put_stream_data();
+
+            return check_execute_direct(rc) && open_results();
+        }
+
+        bool check_execute_direct(SQLRETURN rc) {
+            parameters_pending = false;
+            switch (rc) {
             case SQL_SUCCESS:
-                break;
+                return true;
             case SQL_SUCCESS_WITH_INFO:
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLExecuteDirect() -> SUCCESS_WITH_INFO"});
-                break;
+                return true;
             case SQL_INVALID_HANDLE:
                 last_error = std::string{"could not execute the provided SQL: invalid handle"};
                 diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::string{"SQLExecuteDirect() -> INVALID_HANDLE"});
                 return false;
             default:
-                last_error = std::string{"could not execute the provided SQL: generic error"};
+                if (!std::exchange(stream_failed, false))
+                    last_error = std::string{"could not execute the provided SQL: generic error"};
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLExecuteDirect() -> ERROR"});
                 return false;
             }
+        }
 
-            SQLSMALLINT column_count;
-            if (!SQL_SUCCEEDED(SQLNumResultCols(h_stmt, &column_count))) {
-                last_error = std::string{"could not determine if the SQL query returned one or more result sets"};
+        bool set_paramset_size(std::size_t size) {
+            if (applied.paramset_size == size)
+                return true;
+
+            SQLPOINTER p_paramset_size = reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(size));
+            switch (SQLSetStmtAttrW(h_stmt, SQL_ATTR_PARAMSET_SIZE, p_paramset_size, SQL_IS_UINTEGER)) {
+            case SQL_SUCCESS:
+                applied.paramset_size = size;
+                return true;
+            case SQL_SUCCESS_WITH_INFO:
+                applied.paramset_size = size;
+                diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLSetStmtAttr(SQL_ATTR_PARAMSET_SIZE) -> SUCCESS_WITH_INFO"});
+                return true;
+            case SQL_INVALID_HANDLE:
+                last_error = std::string{"could not set the parameter set size: invalid handle"};
+                diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::string{"SQLSetStmtAttr(SQL_ATTR_PARAMSET_SIZE) -> INVALID_HANDLE"});
+                return false;
+            default:
+                last_error = std::string{"could not set the parameter set size: generic error"};
+                diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLSetStmtAttr(SQL_ATTR_PARAMSET_SIZE) -> ERROR"});
                 return false;
             }
+        }
 
-            if (column_count >= 1) {
+        // (re)binds the parameter arrays only when the layout changes or the rows outgrow the buffers
+        bool bind_batch(const std::vector<statement::sql_parameter_column>& layout, std::size_t row_count) {
+            bool same_layout = layout.size() == batch_layout.size() && std::equal(layout.begin(), layout.end(), batch_layout.begin(), [](const statement::sql_parameter_column& a, const statement::sql_parameter_column& b) {
+                return a.type == b.type && a.max_size == b.max_size;
+            });
+            if (same_layout && row_count <= batch_capacity)
+                return true;
 
-                if (!bind_columns())
+            batch_bindings.clear();
+            batch_layout.clear();
+            batch_capacity = 0;
+            typed_bindings.clear();
+            SQLFreeStmt(h_stmt, SQL_RESET_PARAMS);
+
+            batch_bindings.reserve(layout.size());
+            for (const statement::sql_parameter_column& column : layout)
+                batch_bindings.emplace_back(column, row_count);
+
+            SQLPOINTER p_bind_type = reinterpret_cast<SQLPOINTER>(SQL_PARAM_BIND_BY_COLUMN);
+            if (!SQL_SUCCEEDED(SQLSetStmtAttrW(h_stmt, SQL_ATTR_PARAM_BIND_TYPE, p_bind_type, SQL_IS_UINTEGER))) {
+                last_error = std::string{"could not set column-wise parameter binding"};
+                diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLSetStmtAttr(SQL_ATTR_PARAM_BIND_TYPE) -> ERROR"});
+                batch_bindings.clear();
+                return false;
+            }
+
+            if (!SQL_SUCCEEDED(SQLSetStmtAttrW(h_stmt, SQL_ATTR_PARAMS_PROCESSED_PTR, &batch_rows_processed, SQL_IS_POINTER))) {
+                last_error = std::string{"could not bind the processed parameter set counter"};
+                diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLSetStmtAttr(SQL_ATTR_PARAMS_PROCESSED_PTR) -> ERROR"});
+                batch_bindings.clear();
+                return false;
+            }
+
+            for (std::size_t i = 0; i < batch_bindings.size(); i++) {
+                batch_binding_struct& bb = batch_bindings[i];
+                parameters_dirty = true;
+                switch (SQLBindParameter(h_stmt, static_cast<SQLUSMALLINT>(i + 1), SQL_PARAM_INPUT, bb.c_data_type, bb.sql_data_type, bb.column_size, bb.decimal_digits, bb.buffer.data(), bb.element_length, bb.indicators.data())) {
+                case SQL_SUCCESS:
+                    break;
+                case SQL_SUCCESS_WITH_INFO:
+                    diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::format("SQLBindParameter()::{} -> SUCCESS_WITH_INFO", i));
+                    break;
+                case SQL_INVALID_HANDLE:
+                    last_error = std::format("could not bind parameter array::{} -> invalid handle", i);
+                    diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::format("SQLBindParameter()::{} -> INVALID_HANDLE", i));
+                    batch_bindings.clear();
                     return false;
+                default:
+                    last_error = std::format("could not bind parameter array::{} -> generic error", i);
+                    diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::format("SQLBindParameter()::{} -> ERROR", i));
+                    batch_bindings.clear();
+                    return false;
+                }
+            }
 
-                if (cursor_is_scrollable) {
-                    if (!fetch_first())
-                        return false;
+            batch_layout = layout;
+            batch_capacity = row_count;
+            return true;
+        }
 
-                } else {
-                    if (!fetch_next())
+        // variable length columns are declared in power-of-two buckets so growing values rarely force a rebind, the
+        // buckets stop at the largest size a server still types as varchar(n)/nvarchar(n) rather than (max)
+        static SQLULEN variable_column_size(const simql_binding::parameter_plan& plan, SQLLEN length) {
+            bool is_wide = plan.c_type == SQL_C_WCHAR;
+            SQLULEN units = static_cast<SQLULEN>(std::max<SQLLEN>(length, 0)) / (is_wide ? sizeof(SQLWCHAR) : 1);
+            SQLULEN bounded = is_wide ? simql_constants::limits::max_bounded_wchar_parameter_size : simql_constants::limits::max_bounded_char_parameter_size;
+            if (units > bounded)
+                return std::bit_ceil(units);
+
+            return std::min<SQLULEN>(std::bit_ceil(std::max<SQLULEN>(units, 256)), bounded);
+        }
+
+        // only positions whose type, address or declared size changed since the last call reach SQLBindParameter
+        bool bind_plan(const simql_binding::parameter_plan* plans, const simql_binding::bound_value* values, std::size_t count) {
+
+            // parameter arrays leave a parameter set size behind
+            if (batch_capacity > 0) {
+                SQLFreeStmt(h_stmt, SQL_RESET_PARAMS);
+                batch_bindings.clear();
+                batch_layout.clear();
+                batch_capacity = 0;
+                if (!set_paramset_size(1))
+                    return false;
+            }
+
+            // the indicators move when the bindings grow so every position is bound again
+            if (typed_bindings.size() < count) {
+                typed_bindings.clear();
+                typed_bindings.resize(count);
+            }
+
+            for (std::size_t i = 0; i < count; i++) {
+                const simql_binding::parameter_plan& plan = plans[i];
+                const simql_binding::bound_value& value = values[i];
+                typed_binding_struct& tb = typed_bindings[i];
+
+                SQLULEN column_size = plan.is_variable ? variable_column_size(plan, value.length) : plan.column_size;
+                tb.indicator = value.length;
+                if (tb.plan == &plan && tb.data == value.data && tb.column_size == column_size)
+                    continue;
+
+                SQLLEN buffer_length = plan.is_variable ? static_cast<SQLLEN>(column_size * (plan.c_type == SQL_C_WCHAR ? sizeof(SQLWCHAR) : 1)) : plan.buffer_length;
+                parameters_dirty = true;
+                parameters_pending = true;
+                switch (SQLBindParameter(h_stmt, static_cast<SQLUSMALLINT>(i + 1), SQL_PARAM_INPUT, plan.c_type, plan.sql_type, column_size, plan.decimal_digits, value.data, buffer_length, &tb.indicator)) {
+                case SQL_SUCCESS:
+                    break;
+                case SQL_SUCCESS_WITH_INFO:
+                    diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::format("SQLBindParameter()::{} -> SUCCESS_WITH_INFO", i));
+                    break;
+                case SQL_INVALID_HANDLE:
+                    tb.plan = nullptr;
+                    last_error = std::format("could not bind parameter::{} -> invalid handle", i);
+                    diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::format("SQLBindParameter()::{} -> INVALID_HANDLE", i));
+                    return false;
+                default:
+                    tb.plan = nullptr;
+                    last_error = std::format("could not bind parameter::{} -> generic error", i);
+                    diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::format("SQLBindParameter()::{} -> ERROR", i));
+                    return false;
+                }
+
+                tb.plan = &plan;
+                tb.data = value.data;
+                tb.column_size = column_size;
+            }
+            return true;
+        }
+
+        // SQL_RESET_PARAMS cannot spare single positions, so typed arguments are never mixed with the other kinds
+        bool only_typed_bindings() {
+            if (stream_bindings.empty() && parameter_bindings.empty())
+                return true;
+
+            last_error = std::string{"cannot execute with arguments while parameters are bound through bind_stream or bind_parameters"};
+            return false;
+        }
+
+        // SQL_RESET_PARAMS drops every parameter binding of the handle, which only_typed_bindings made sure are typed ones
+        void release_typed_bindings() {
+            if (typed_bindings.empty())
+                return;
+
+            SQLFreeStmt(h_stmt, SQL_RESET_PARAMS);
+            typed_bindings.clear();
+            parameters_dirty = false;
+        }
+
+        bool execute_batch(const std::vector<statement::sql_parameter_column>& layout, const std::vector<statement::sql_row>& rows) {
+            if (rows.empty())
+                return true;
+
+            if (layout.empty()) {
+                last_error = std::string{"the parameter array layout is empty"};
+                return false;
+            }
+
+            for (const statement::sql_row& row : rows) {
+                if (row.size() != layout.size()) {
+                    last_error = std::format("could not execute the batch -> expected {} values per row but received {}", layout.size(), row.size());
+                    return false;
+                }
+            }
+
+            if (!bind_batch(layout, rows.size()))
+                return false;
+
+            // one mistyped value fails the whole batch before anything is written
+            for (std::size_t r = 0; r < rows.size(); r++) {
+                for (std::size_t c = 0; c < batch_bindings.size(); c++) {
+                    if (!batch_bindings[c].accepts(rows[r][c])) {
+                        last_error = std::format("could not execute the batch -> row {} column {} does not hold the layout's data type", r, c);
                         return false;
+                    }
+                }
+            }
+
+            for (std::size_t r = 0; r < rows.size(); r++) {
+                for (std::size_t c = 0; c < batch_bindings.size(); c++)
+                    batch_bindings[c].write(r, rows[r][c]);
+            }
+
+            if (!set_paramset_size(rows.size()))
+                return false;
+
+            return execute();
+        }
+
+        // --------------------------------------------------
+        // STREAMED PARAMETERS
+        // --------------------------------------------------
+
+        bool put_chunk(std::uint8_t position, SQLPOINTER data, SQLLEN length) {
+            switch (SQLPutData(h_stmt, data, length)) {
+            case SQL_SUCCESS:
+                return true;
+            case SQL_SUCCESS_WITH_INFO:
+                diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::format("SQLPutData()::{} -> SUCCESS_WITH_INFO", position));
+                return true;
+            case SQL_INVALID_HANDLE:
+                last_error = std::format("could not send the streamed parameter::{} -> invalid handle", position);
+                diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::format("SQLPutData()::{} -> INVALID_HANDLE", position));
+                return false;
+            default:
+                last_error = std::format("could not send the streamed parameter::{} -> generic error", position);
+                diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::format("SQLPutData()::{} -> ERROR", position));
+                return false;
+            }
+        }
+
+        // last_error already names the failed stream, check_execute keeps it
+        SQLRETURN abort_stream_data() {
+            SQLCancel(h_stmt);
+            stream_failed = true;
+            return SQL_ERROR;
+        }
+
+        // feeds every data-at-execution parameter through the shared chunk buffer and returns the final execution code
+        SQLRETURN put_stream_data() {
+
+            // a source left mid-stream by an aborted execution starts over
+            stream_failed = false;
+            for (stream_binding_struct& binding : stream_bindings) {
+                if (binding.parameter.rewind)
+                    binding.parameter.rewind();
+            }
+
+            SQLPOINTER token{nullptr};
+            SQLRETURN rc = SQLParamData(h_stmt, &token);
+            while (rc == SQL_NEED_DATA) {
+                stream_binding_struct* binding = static_cast<stream_binding_struct*>(token);
+                statement::sql_parameter_stream& param = binding->parameter;
+                std::size_t capacity = std::min<std::size_t>(param.chunk_size, stream_buffer.size());
+
+                bool has_sent{false};
+                while (true) {
+                    std::int64_t count = param.source(stream_buffer.data(), capacity);
+                    if (count < 0) {
+                        last_error = std::format("{}::{} -> source error", simql_returncodes::description(simql_returncodes::code::error_stmt_stream_data), param.position);
+                        return abort_stream_data();
+                    }
 
+                    if (count == 0)
+                        break;
+
+                    if (!put_chunk(param.position, stream_buffer.data(), static_cast<SQLLEN>(std::min<std::size_t>(static_cast<std::size_t>(count), capacity))))
+                        return abort_stream_data();
+                    has_sent = true;
                 }
+
+                // an empty source still has to report a zero length value
+                if (!has_sent && !put_chunk(param.position, stream_buffer.data(), 0))
+                    return abort_stream_data();
+
+                rc = SQLParamData(h_stmt, &token);
             }
+            return rc;
+        }
+
+        // --------------------------------------------------
+        // ASYNCHRONOUS EXECUTION
+        // --------------------------------------------------
 
+        static simql_types::async_status to_status(bool ok) {
+            return ok ? simql_types::async_status::complete : simql_types::async_status::failed;
+        }
+
+        // the same arguments have to be passed on every call until the driver stops returning SQL_STILL_EXECUTING
+        SQLRETURN issue_async() {
+            switch (pending) {
+            case async_step::prepare:
+                return SQLPrepareW(h_stmt, pending_w_sql.data(), SQL_NTS);
+            case async_step::execute:
+                return SQLExecute(h_stmt);
+            case async_step::execute_direct:
+                return SQLExecDirectW(h_stmt, pending_w_sql.data(), SQL_NTS);
+            case async_step::fetch_first:
+                return SQLFetchScroll(h_stmt, SQL_FETCH_FIRST, 0);
+            case async_step::fetch_next:
+                return SQLFetchScroll(h_stmt, SQL_FETCH_NEXT, 0);
+            default:
+                return SQL_ERROR;
+            }
+        }
+
+        // the handle only runs asynchronously for the duration of a call, everything else stays synchronous
+        void settle() {
+            pending = async_step::none;
+            pending_w_sql.clear();
+            set_async(false);
+        }
+
+        // polls once right away, a driver refusing SQL_ATTR_ASYNC_ENABLE runs the whole call in that first poll
+        simql_types::async_status begin_async(async_step step) {
+            if ((step == async_step::fetch_first || step == async_step::fetch_next) && !update_fetched_row_count())
+                return simql_types::async_status::failed;
+
+            pending = step;
+            set_async(true);
+            return poll_async();
+        }
+
+        // describing and binding the result columns is quick, only the first fetch is worth running asynchronously
+        simql_types::async_status begin_results() {
+            SQLSMALLINT column_count;
+            if (!SQL_SUCCEEDED(SQLNumResultCols(h_stmt, &column_count))) {
+                last_error = std::string{"could not determine if the SQL query returned one or more result sets"};
+                return simql_types::async_status::failed;
+            }
+
+            // as in open_results, columns defined after the execution wait for the first navigation
+            at_end = false;
+            rows_fetched = 0;
+            current_row_index = 0;
+            if (column_count < 1 || column_bindings.empty())
+                return simql_types::async_status::complete;
+
+            if (!bind_columns()) {
+                last_error = std::string{"could not bind the columns"};
+                return simql_types::async_status::failed;
+            }
+
+            pending_first_rowset = true;
+            return begin_async(cursor_is_scrollable ? async_step::fetch_first : async_step::fetch_next);
+        }
+
+        simql_types::async_status poll_async() {
+            if (pending == async_step::none)
+                return simql_types::async_status::complete;
+
+            SQLRETURN rc = issue_async();
+            if (rc == SQL_STILL_EXECUTING)
+                return simql_types::async_status::pending;
+
+            async_step step = pending;
+            settle();
+
+            switch (step) {
+            case async_step::prepare: {
+                std::string sql = std::move(pending_sql);
+                pending_sql.clear();
+                return to_status(finish_prepare(rc, sql, pending_key));
+            }
+            case async_step::execute:
+                return check_execute(rc) ? begin_results() : simql_types::async_status::failed;
+            case async_step::execute_direct:
+                return check_execute_direct(rc) ? begin_results() : simql_types::async_status::failed;
+            case async_step::fetch_first:
+            case async_step::fetch_next: {
+                bool first_rowset = std::exchange(pending_first_rowset, false);
+                if (!(step == async_step::fetch_first ? finish_fetch_first(record_fetch(rc)) : finish_fetch_next(record_fetch(rc))) && !(first_rowset && at_end))
+                    return simql_types::async_status::failed;
+
+                current_row_index = 0;
+                load_row();
+                return simql_types::async_status::complete;
+            }
+            default:
+                return simql_types::async_status::complete;
+            }
+        }
+
+        // a call still running is cancelled and waited out before the HSTMT is reused or freed
+        void abandon_async() {
+            if (pending == async_step::none)
+                return;
+
+            SQLCancel(h_stmt);
+            while (issue_async() == SQL_STILL_EXECUTING)
+                std::this_thread::yield();
+
+            pending_sql.clear();
+            pending_first_rowset = false;
+            settle();
+        }
+
+        bool is_busy() {
+            if (pending == async_step::none)
+                return false;
+
+            last_error = std::string{"an asynchronous call is still pending on the statement"};
             return true;
         }
 
+        simql_types::async_status prepare_async(std::string_view sql) {
+            if (is_busy())
+                return simql_types::async_status::failed;
+
+            std::size_t key = cache_key(sql);
+            bool cached{false};
+            if (!ready_for_prepare(sql, key, cached))
+                return simql_types::async_status::failed;
+
+            if (cached)
+                return simql_types::async_status::complete;
+
+            pending_w_sql = simql_strings::to_odbc_w(sql);
+            pending_sql = std::string(sql);
+            pending_key = key;
+            return begin_async(async_step::prepare);
+        }
+
+        // streamed parameters are fed from the calling thread between SQLParamData calls, those executes run synchronously
+        simql_types::async_status execute_async() {
+            if (is_busy())
+                return simql_types::async_status::failed;
+
+            if (!stream_bindings.empty())
+                return to_status(execute());
+
+            simql_metrics::add(simql_metrics::counter::executes);
+            cursor_dirty = true;
+            return begin_async(async_step::execute);
+        }
+
+        simql_types::async_status execute_direct_async(std::string_view sql) {
+            if (is_busy())
+                return simql_types::async_status::failed;
+
+            if (!stream_bindings.empty())
+                return to_status(execute_direct(sql));
+
+            // direct execution discards whatever was prepared on the handle
+            prepared_sql.clear();
+            pending_w_sql = simql_strings::to_odbc_w(sql);
+            simql_metrics::add(simql_metrics::counter::executes);
+            cursor_dirty = true;
+            return begin_async(async_step::execute_direct);
+        }
+
+        // moves within the current rowset without a call, only fetching the next rowset goes to the driver
+        simql_types::async_status next_record_async() {
+            if (is_busy())
+                return simql_types::async_status::failed;
+
+            if (column_bindings.size() == 0) {
+                last_error = std::string{"no columns are bound"};
+                return simql_types::async_status::failed;
+            }
+
+            if (current_row_index + 1 < rows_fetched) {
+                current_row_index++;
+                load_row();
+                return simql_types::async_status::complete;
+            }
+
+            if (!bind_columns()) {
+                last_error = std::string{"could not bind the columns"};
+                return simql_types::async_status::failed;
+            }
+
+            return begin_async(async_step::fetch_next);
+        }
+
         // --------------------------------------------------
         // FILL DATA BUFFERS
         // --------------------------------------------------
 
+        // counts the bytes the driver wrote into the bound buffers, truncated values count as the full buffer
+        SQLRETURN fetch_scroll(SQLSMALLINT orientation) {
+            if (!update_fetched_row_count())
+                return SQL_ERROR;
+
+            return record_fetch(simql_metrics::timed(simql_metrics::timer::odbc_fetch, [&]() { return SQLFetchScroll(h_stmt, orientation, 0); }));
+        }
+
+        SQLRETURN record_fetch(SQLRETURN rc) {
+            if (!simql_metrics::enabled())
+                return rc;
+
+            simql_metrics::add(simql_metrics::counter::fetches);
+            if (!SQL_SUCCEEDED(rc))
+                return rc;
+
+            std::uint64_t bytes{0};
+            for (column_binding_struct& binding : column_bindings) {
+                for (SQLUINTEGER row = 0; row < rows_fetched && row < binding.indicators.size(); row++) {
+                    SQLLEN indicator = binding.indicators[row];
+                    if (indicator == SQL_NO_TOTAL)
+                        bytes += static_cast<std::uint64_t>(binding.buffer_length);
+                    else if (indicator > 0)
+                        bytes += static_cast<std::uint64_t>(std::min(indicator, binding.buffer_length));
+                }
+            }
+            simql_metrics::add(simql_metrics::counter::rows_fetched, rows_fetched);
+            simql_metrics::add(simql_metrics::counter::bytes_fetched, bytes);
+            return rc;
+        }
+
         bool fetch_first() {
 
             if (!bind_columns()) {
@@ -1264,12 +2375,20 @@ namespace simql {
                 return false;
             }
 
-            switch (SQLFetchScroll(h_stmt, SQL_FETCH_FIRST, 0)) {
+            return finish_fetch_first(fetch_scroll(SQL_FETCH_FIRST));
+        }
+
+        bool finish_fetch_first(SQLRETURN rc) {
+            switch (rc) {
             case SQL_SUCCESS:
                 return update_fetched_row_count();
             case SQL_SUCCESS_WITH_INFO:
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLFetchScroll(SQL_FETCH_FIRST) -> SUCCESS_WITH_INFO"});
                 return update_fetched_row_count();
+            case SQL_NO_DATA:
+                rows_fetched = 0;
+                at_end = true;
+                return false;
             case SQL_INVALID_HANDLE:
                 last_error = std::string{"could not fetch-first from the result set: invalid handle"};
                 diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::string{"SQLFetchScroll(SQL_FETCH_FIRST) -> INVALID_HANDLE"});
@@ -1288,12 +2407,16 @@ namespace simql {
                 return false;
             }
 
-            switch (SQLFetchScroll(h_stmt, SQL_FETCH_LAST, 0)) {
+            switch (fetch_scroll(SQL_FETCH_LAST)) {
             case SQL_SUCCESS:
                 return update_fetched_row_count();
             case SQL_SUCCESS_WITH_INFO:
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLFetchScroll(SQL_FETCH_LAST) -> SUCCESS_WITH_INFO"});
                 return update_fetched_row_count();
+            case SQL_NO_DATA:
+                rows_fetched = 0;
+                at_end = true;
+                return false;
             case SQL_INVALID_HANDLE:
                 last_error = std::string{"could not fetch-last from the result set: invalid handle"};
                 diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::string{"SQLFetchScroll(SQL_FETCH_LAST) -> INVALID_HANDLE"});
@@ -1312,12 +2435,16 @@ namespace simql {
                 return false;
             }
 
-            switch (SQLFetchScroll(h_stmt, SQL_FETCH_PREV, 0)) {
+            switch (fetch_scroll(SQL_FETCH_PREV)) {
             case SQL_SUCCESS:
                 return update_fetched_row_count();
             case SQL_SUCCESS_WITH_INFO:
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLFetchScroll(SQL_FETCH_PREV) -> SUCCESS_WITH_INFO"});
                 return update_fetched_row_count();
+            case SQL_NO_DATA:
+                rows_fetched = 0;
+                at_end = true;
+                return false;
             case SQL_INVALID_HANDLE:
                 last_error = std::string{"could not fetch-prev from the result set: invalid handle"};
                 diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::string{"SQLFetchScroll(SQL_FETCH_PREV) -> INVALID_HANDLE"});
@@ -1336,12 +2463,20 @@ namespace simql {
                 return false;
             }
 
-            switch (SQLFetchScroll(h_stmt, SQL_FETCH_NEXT, 0)) {
+            return finish_fetch_next(fetch_scroll(SQL_FETCH_NEXT));
+        }
+
+        bool finish_fetch_next(SQLRETURN rc) {
+            switch (rc) {
             case SQL_SUCCESS:
                 return update_fetched_row_count();
             case SQL_SUCCESS_WITH_INFO:
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::string{"SQLFetchScroll(SQL_FETCH_NEXT) -> SUCCESS_WITH_INFO"});
                 return update_fetched_row_count();
+            case SQL_NO_DATA:
+                rows_fetched = 0;
+                at_end = true;
+                return false;
             case SQL_INVALID_HANDLE:
                 last_error = std::string{"could not fetch-next from the result set: invalid handle"};
                 diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::string{"SQLFetchScroll(SQL_FETCH_NEXT) -> INVALID_HANDLE"});
@@ -1357,6 +2492,15 @@ namespace simql {
         // RESULT NAVIGATION
         // --------------------------------------------------
 
+        // copies the current row of the rowset buffers into the attached columns
+        void load_row() {
+            if (current_row_index >= rows_fetched)
+                return;
+
+            for (column_binding_struct& binding : column_bindings)
+                binding.update(current_row_index);
+        }
+
         bool first_record() {
 
             if (column_bindings.size() == 0) {
@@ -1373,6 +2517,7 @@ namespace simql {
                 return false;
 
             current_row_index = 0;
+            load_row();
             return true;
         }
 
@@ -1392,6 +2537,7 @@ namespace simql {
                 return false;
 
             current_row_index = rows_fetched - 1;
+            load_row();
             return true;
         }
 
@@ -1402,7 +2548,7 @@ namespace simql {
                 return false;
             }
 
-            if (current_row_index - 1 > 0) {
+            if (current_row_index > 0) {
                 current_row_index--;
             } else {
 
@@ -1417,6 +2563,7 @@ namespace simql {
                 current_row_index = rows_fetched - 1;
             }
 
+            load_row();
             return true;
         }
 
@@ -1437,13 +2584,16 @@ namespace simql {
                 current_row_index = 0;
             }
 
+            load_row();
             return true;
         }
 
         bool next_result_set() {
             SQLFreeStmt(h_stmt, SQL_UNBIND);
             column_bindings.clear();
-            switch (SQLMoreResults(h_stmt)) {
+            columns_bound = false;
+            attached_columns = 0;
+            switch (simql_metrics::timed(simql_metrics::timer::odbc_more_results, [&]() { return SQLMoreResults(h_stmt); })) {
             case SQL_SUCCESS:
                 return true;
             case SQL_SUCCESS_WITH_INFO:
@@ -1465,7 +2615,7 @@ namespace simql {
         bool goto_bound_parameters() {
             bool exit_condition{false};
             while (true) {
-                switch (SQLMoreResults(h_stmt)) {
+                switch (simql_metrics::timed(simql_metrics::timer::odbc_more_results, [&]() { return SQLMoreResults(h_stmt); })) {
                 case SQL_SUCCESS:
                     break;
                 case SQL_SUCCESS_WITH_INFO:
@@ -1521,37 +2671,103 @@ namespace simql {
         // PARAMETER BINDING
         // --------------------------------------------------
 
-        template<parameter_binding_typename T>
+        // the binding lives in parameter_bindings so its buffer and indicator stay put until the parameters are reset
+        template<typename T> requires std::derived_from<T, statement::sql_parameter>
         bool bind_parameter(T& param) {
-            auto it = parameter_bindings.find(param.name);
-            if (it != parameter_bindings.end()) {
+            if (is_parameter_bound(param.position)) {
                 last_error = std::string{"cannot bind duplicate parameters"};
                 return false;
             }
 
-            parameter_binding_struct pb(param);
-            switch (SQLBindParameter(h_stmt, 0, pb.binding_type, pb.c_data_type, pb.sql_data_type, pb.column_size, pb.decimal_digits, pb.ptr(), pb.buffer_length, &pb.indicator)) {
+            parameter_binding_struct& pb = parameter_bindings.try_emplace(param.position, param).first->second;
+            parameters_dirty = true;
+            parameters_pending = true;
+            switch (SQLBindParameter(h_stmt, param.position + 1, pb.binding_type, pb.c_data_type, pb.sql_data_type, pb.column_size, pb.decimal_digits, pb.ptr(), pb.buffer_length, &pb.indicator)) {
             case SQL_SUCCESS:
                 break;
             case SQL_SUCCESS_WITH_INFO:
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::format("SQLBindParameter()::{} -> SUCCESS_WITH_INFO", param.position));
                 break;
             case SQL_INVALID_HANDLE:
+                parameter_bindings.erase(param.position);
                 last_error = std::format("could not bind parameter::{} -> invalid handle", param.position);
                 diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::format("SQLBindParameter()::{} -> INVALID_HANDLE", param.position));
                 return false;
             default:
+                parameter_bindings.erase(param.position);
                 last_error = std::format("could not bind parameter::{} -> generic error", param.position);
                 diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::format("SQLBindParameter()::{} -> ERROR", param.position));
                 return false;
             }
+
+            return true;
+        }
+
+        // a position taken by a streamed, a regular or a typed parameter
+        bool is_parameter_bound(std::uint8_t position) {
+            for (stream_binding_struct& binding : stream_bindings) {
+                if (binding.parameter.position == position)
+                    return true;
+            }
+
+            if (parameter_bindings.contains(position))
+                return true;
+
+            return position < typed_bindings.size() && typed_bindings[position].plan;
+        }
+
+        bool bind_stream(statement::sql_parameter_stream& param) {
+            if (is_parameter_bound(param.position)) {
+                last_error = std::string(simql_returncodes::description(simql_returncodes::code::error_set_param_duplicate));
+                return false;
+            }
+
+            if (!param.source) {
+                last_error = std::format("could not bind parameter::{} -> the stream has no source", param.position);
+                return false;
+            }
+
+            if (param.chunk_size == 0) {
+                last_error = std::format("could not bind parameter::{} -> the chunk size must be larger than 0", param.position);
+                return false;
+            }
+
+            stream_binding_struct& sb = stream_bindings.emplace_back(param);
+            SQLSMALLINT c_data_type = param.is_text ? SQL_C_CHAR : SQL_C_BINARY;
+            SQLSMALLINT sql_data_type = param.is_text ? SQL_LONGVARCHAR : SQL_LONGVARBINARY;
+            SQLULEN column_size = param.total_length > 0 ? static_cast<SQLULEN>(param.total_length) : 0;
+            parameters_dirty = true;
+            parameters_pending = true;
+            switch (SQLBindParameter(h_stmt, param.position + 1, SQL_PARAM_INPUT, c_data_type, sql_data_type, column_size, 0, reinterpret_cast<SQLPOINTER>(&sb), 0, &sb.indicator)) {
+            case SQL_SUCCESS:
+                break;
+            case SQL_SUCCESS_WITH_INFO:
+                diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::format("SQLBindParameter()::{} -> SUCCESS_WITH_INFO", param.position));
+                break;
+            case SQL_INVALID_HANDLE:
+                stream_bindings.pop_back();
+                last_error = std::format("could not bind parameter::{} -> invalid handle", param.position);
+                diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::format("SQLBindParameter()::{} -> INVALID_HANDLE", param.position));
+                return false;
+            default:
+                stream_bindings.pop_back();
+                last_error = std::format("could not bind parameter::{} -> generic error", param.position);
+                diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::format("SQLBindParameter()::{} -> ERROR", param.position));
+                return false;
+            }
+
+            // one buffer serves every stream so memory use is bounded by the largest chunk
+            if (stream_buffer.size() < param.chunk_size)
+                stream_buffer.resize(param.chunk_size);
+
+            return true;
         }
 
         // --------------------------------------------------
         // COLUMN BINDING
         // --------------------------------------------------
 
-        template<column_binding_typename T>
+        template<typename T> requires std::derived_from<T, statement::sql_column>
         bool add_column(T& col) {
 
             SQLUINTEGER rowset_size{};
@@ -1576,28 +2792,48 @@ namespace simql {
                 return false;
             }
 
-            column_bindings.emplace_back(column_binding_struct(rowset_size, col));
+            // a cached binding plan is reused as long as the column asks for the same buffer
+            if (attached_columns < column_bindings.size()) {
+                column_binding_struct& cached = column_bindings[attached_columns];
+                column_binding_struct shape(0, col);
+                if (cached.position == shape.position && cached.c_type == shape.c_type && cached.buffer_length == shape.buffer_length) {
+                    cached.column = &col;
+                    attached_columns++;
+                    return true;
+                }
+
+                SQLFreeStmt(h_stmt, SQL_UNBIND);
+                column_bindings.erase(column_bindings.begin() + attached_columns, column_bindings.end());
+            }
+
+            column_bindings.emplace_back(rowset_size, col);
+            attached_columns++;
+            columns_bound = false;
             return true;
         }
 
         bool bind_columns() {
+            if (columns_bound)
+                return true;
+
             for (column_binding_struct& binding : column_bindings) {
-                switch (SQLBindCol(h_stmt, binding.column.position + 1, binding.c_type, binding.ptr(), binding.buffer_length, binding.indicators.data())) {
+                switch (SQLBindCol(h_stmt, binding.position + 1, binding.c_type, binding.ptr(), binding.buffer_length, binding.indicators.data())) {
                 case SQL_SUCCESS:
                     break;
                 case SQL_SUCCESS_WITH_INFO:
-                    diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::format("SQLBindCol()::{} -> SUCCESS_WITH_INFO", binding.column.position));
+                    diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::format("SQLBindCol()::{} -> SUCCESS_WITH_INFO", binding.position));
                     break;
                 case SQL_INVALID_HANDLE:
-                    last_error = std::format("could not bind column::{} -> invalid handle", binding.column.position);
-                    diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::format("SQLBindCol()::{} -> INVALID_HANDLE", binding.column.position));
+                    last_error = std::format("could not bind column::{} -> invalid handle", binding.position);
+                    diag.update(h_dbc, diagnostic_set::handle_type::dbc, std::format("SQLBindCol()::{} -> INVALID_HANDLE", binding.position));
                     return false;
                 default:
-                    last_error = std::format("could not bind column::{} -> generic error", binding.column.position);
-                    diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::format("SQLBindCol()::{} -> INVALID_HANDLE", binding.column.position));
+                    last_error = std::format("could not bind column::{} -> generic error", binding.position);
+                    diag.update(h_stmt, diagnostic_set::handle_type::stmt, std::format("SQLBindCol()::{} -> INVALID_HANDLE", binding.position));
                     return false;
                 }
             }
+            columns_bound = true;
             return true;
         }
 
@@ -1624,10 +2860,42 @@ namespace simql {
         return p_handle ? p_handle->execute() : false;
     }
 
+    bool statement::cancel() {
+        return p_handle ? p_handle->cancel() : false;
+    }
+
     bool statement::execute_direct(std::string_view sql) {
         return p_handle ? p_handle->execute_direct(sql) : false;
     }
 
+    simql_types::async_status statement::prepare_async(std::string_view sql) {
+        return p_handle ? p_handle->prepare_async(sql) : simql_types::async_status::failed;
+    }
+
+    simql_types::async_status statement::execute_async() {
+        return p_handle ? p_handle->execute_async() : simql_types::async_status::failed;
+    }
+
+    simql_types::async_status statement::execute_direct_async(std::string_view sql) {
+        return p_handle ? p_handle->execute_direct_async(sql) : simql_types::async_status::failed;
+    }
+
+    simql_types::async_status statement::next_record_async() {
+        return p_handle ? p_handle->next_record_async() : simql_types::async_status::failed;
+    }
+
+    simql_types::async_status statement::poll() {
+        return p_handle ? p_handle->poll_async() : simql_types::async_status::failed;
+    }
+
+    bool statement::is_pending() {
+        return p_handle && p_handle->pending != handle::async_step::none;
+    }
+
+    bool statement::execute_batch(const std::vector<statement::sql_parameter_column>& layout, const std::vector<statement::sql_row>& rows) {
+        return p_handle ? p_handle->execute_batch(layout, rows) : false;
+    }
+
     // --------------------------------------------------
     // RESULT NAVIGATION
     // --------------------------------------------------
@@ -1648,6 +2916,10 @@ namespace simql {
         return !p_handle ? false : p_handle->next_record();
     }
 
+    bool statement::at_end() {
+        return p_handle ? p_handle->at_end : false;
+    }
+
     bool statement::next_result_set() {
         return !p_handle ? false : p_handle->next_result_set();
     }
@@ -1668,12 +2940,60 @@ namespace simql {
     // COLUMN BINDING
     // --------------------------------------------------
 
-    template<typename... T> requires (std::derived_from<std::remove_cvref_t<T>, statement::sql_column> && ...)
-    bool statement::define_columns(T&... columns) {
-        if (!p_handle)
-            return false;
+    bool statement::add_column(statement::sql_column_string& column) {
+        return !p_handle ? false : p_handle->add_column(column);
+    }
+
+    bool statement::add_column(statement::sql_column_character& column) {
+        return !p_handle ? false : p_handle->add_column(column);
+    }
+
+    bool statement::add_column(statement::sql_column_boolean& column) {
+        return !p_handle ? false : p_handle->add_column(column);
+    }
+
+    bool statement::add_column(statement::sql_column_double& column) {
+        return !p_handle ? false : p_handle->add_column(column);
+    }
+
+    bool statement::add_column(statement::sql_column_float& column) {
+        return !p_handle ? false : p_handle->add_column(column);
+    }
+
+    bool statement::add_column(statement::sql_column_int8& column) {
+        return !p_handle ? false : p_handle->add_column(column);
+    }
+
+    bool statement::add_column(statement::sql_column_int16& column) {
+        return !p_handle ? false : p_handle->add_column(column);
+    }
+
+    bool statement::add_column(statement::sql_column_int32& column) {
+        return !p_handle ? false : p_handle->add_column(column);
+    }
 
-        return p_handle->add_column(columns...);
+    bool statement::add_column(statement::sql_column_int64& column) {
+        return !p_handle ? false : p_handle->add_column(column);
+    }
+
+    bool statement::add_column(statement::sql_column_guid& column) {
+        return !p_handle ? false : p_handle->add_column(column);
+    }
+
+    bool statement::add_column(statement::sql_column_datetime& column) {
+        return !p_handle ? false : p_handle->add_column(column);
+    }
+
+    bool statement::add_column(statement::sql_column_date& column) {
+        return !p_handle ? false : p_handle->add_column(column);
+    }
+
+    bool statement::add_column(statement::sql_column_time& column) {
+        return !p_handle ? false : p_handle->add_column(column);
+    }
+
+    bool statement::add_column(statement::sql_column_blob& column) {
+        return !p_handle ? false : p_handle->add_column(column);
     }
 
     // --------------------------------------------------
@@ -1685,7 +3005,57 @@ namespace simql {
         if (!p_handle)
             return false;
 
-        return p_handle->bind_parameter(parameters...);
+        return (p_handle->bind_parameter(parameters) && ...);
+    }
+
+    bool statement::bind_stream(statement::sql_parameter_stream& parameter) {
+        return !p_handle ? false : p_handle->bind_stream(parameter);
+    }
+
+    // the stream sources rewind after reporting the end so the statement can be executed again
+    statement::sql_parameter_stream statement::sql_parameter_stream::from_file(std::uint8_t position, const std::filesystem::path& path, bool is_text) {
+        std::error_code ec;
+        std::uintmax_t size = std::filesystem::file_size(path, ec);
+        auto file = std::make_shared<std::ifstream>(path, std::ios::binary);
+        auto source = [file](std::uint8_t* buffer, std::size_t capacity) -> std::int64_t {
+            if (!file->is_open())
+                return -1;
+
+            file->read(reinterpret_cast<char*>(buffer), static_cast<std::streamsize>(capacity));
+            if (file->bad())
+                return -1;
+
+            std::streamsize count = file->gcount();
+            if (count == 0) {
+                file->clear();
+                file->seekg(0);
+            }
+            return static_cast<std::int64_t>(count);
+        };
+        statement::sql_parameter_stream stream(position, std::move(source), ec ? -1 : static_cast<std::int64_t>(size), is_text);
+        stream.rewind = [file]() {
+            file->clear();
+            file->seekg(0);
+        };
+        return stream;
+    }
+
+    statement::sql_parameter_stream statement::sql_parameter_stream::from_memory(std::uint8_t position, const std::uint8_t* data, std::size_t size, bool is_text) {
+        auto offset = std::make_shared<std::size_t>(0);
+        auto source = [data, size, offset](std::uint8_t* buffer, std::size_t capacity) -> std::int64_t {
+            std::size_t count = std::min(capacity, size - *offset);
+            if (count == 0) {
+                *offset = 0;
+                return 0;
+            }
+
+            std::copy_n(data + *offset, count, buffer);
+            *offset += count;
+            return static_cast<std::int64_t>(count);
+        };
+        statement::sql_parameter_stream stream(position, std::move(source), static_cast<std::int64_t>(size), is_text);
+        stream.rewind = [offset]() { *offset = 0; };
+        return stream;
     }
 
     // --------------------------------------------------
@@ -1708,9 +3078,46 @@ namespace simql {
     // PRIVATE
     // --------------------------------------------------
 
-    statement::statement(void* raw_stmt_handle, database_connection& conn, void* pool) : p_handle(std::make_unique<handle>(raw_stmt_handle, conn, pool)) {}
+    statement::statement(void* raw_stmt_handle, database_connection* conn, void* pool, const statement::alloc_options& options, const simql_types::cursor_attributes& cursor, std::string_view sql, std::shared_ptr<void> plan) : p_handle(std::make_unique<handle>(raw_stmt_handle, conn, pool, options, cursor, sql, std::move(plan))) {}
+
+    bool statement::bind_plan(const simql_binding::parameter_plan* plans, const simql_binding::bound_value* values, std::size_t count) {
+        return !p_handle ? false : p_handle->bind_plan(plans, values, count);
+    }
+
+    // prepares the SQL on a new handle and binds the plan's column buffers to it, destroying the statement
+    // then parks the handle in the connection's cache ready for the next prepare of the same SQL
+    bool restore_cached_statement(database_connection& dbc, const statement::alloc_options& options, std::string_view sql, std::shared_ptr<void> plan) {
+        statement stmt(dbc, options);
+        if (!stmt.is_valid() || !stmt.prepare(sql))
+            return false;
+
+        if (!plan)
+            return true;
+
+        stmt.p_handle->adopt_plan(std::move(plan));
+        stmt.p_handle->columns_bound = false;
+        return stmt.p_handle->bind_columns();
+    }
+
+    bool statement::only_typed_bindings() {
+        return !p_handle ? false : p_handle->only_typed_bindings();
+    }
+
+    // drops the typed parameter bindings, the open cursor, the prepared SQL and the column bindings stay
+    void statement::release_typed_bindings() {
+        if (p_handle && p_handle->h_stmt)
+            p_handle->release_typed_bindings();
+    }
+
+    // a statement reused by another task keeps its prepared SQL and column buffers but none of the previous columns
+    void statement::reset_execution_state() {
+        if (p_handle && p_handle->h_stmt) {
+            p_handle->clear_execution_state();
+            p_handle->detach_columns();
+        }
+    }
 
-    void* statement::detach_handle() noexcept {
+    void* statement::detach_handle(std::string& sql, std::shared_ptr<void>& plan, database_connection*& conn, simql_types::cursor_attributes& cursor) {
         if (!p_handle)
             return nullptr;
 
@@ -1720,9 +3127,9 @@ namespace simql {
         if (p_handle->ownership == handle_ownership::owns)
             return nullptr;
 
-        SQLHSTMT h = p_handle->h_stmt;
-        p_handle->h_stmt = SQL_NULL_HSTMT;
-        return reinterpret_cast<void*>(h);
+        conn = p_handle->p_dbc;
+        cursor = p_handle->cursor_state();
+        return reinterpret_cast<void*>(p_handle->detach(sql, plan));
     }
 
 }
\ No newline at end of file
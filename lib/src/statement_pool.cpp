@@ -2,14 +2,28 @@
 #include "statement_pool.hpp"
 #include "database_connection.hpp"
 #include "statement.hpp"
+#include "simql_queues.hpp"
+#include "simql_metrics.hpp"
 
 // STL stuff
 #include <cstdint>
 #include <memory>
+#include <array>
+#include <atomic>
 #include <deque>
+#include <thread>
+#include <algorithm>
+#include <bit>
+#include <list>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 #include <mutex>
 #include <condition_variable>
 #include <chrono>
+#include <functional>
+#include <limits>
 
 // OS stuff
 #include "os_inclusions.hpp"
@@ -23,24 +37,146 @@ namespace simql {
 
     extern void* get_dbc_handle(database_connection&) noexcept;
 
+    // a prepared handle carries its SQL and the column bindings as an opaque plan, a cold handle has neither,
+    // both carry the cursor attributes the driver applied so a lease never has to ask for them
     struct pooled_statement {
         SQLHSTMT h_stmt = SQL_NULL_HSTMT;
         std::chrono::steady_clock::time_point last_used{};
+        std::string sql{};
+        std::shared_ptr<void> plan{};
+        std::uint32_t shard{0};
+        simql_types::cursor_attributes cursor{};
     };
 
-    struct statement_pool::pool {
+    // a cold handle as it sits in the lock-free stack
+    struct idle_statement {
+        SQLHSTMT h_stmt = SQL_NULL_HSTMT;
+        std::chrono::steady_clock::time_point last_used{};
+        simql_types::cursor_attributes cursor{};
+    };
+
+    // the handles allocated on one connection of the pool
+    struct pool_shard {
         database_connection& connection;
         SQLHDBC h_dbc = SQL_NULL_HDBC;
-        std::deque<pooled_statement> statements;
+        std::uint32_t index;
+
+        // cold handles, most recently released on top so reuse stays on warm handles and the cold ones age out,
+        // acquire and release never lock on this path
+        simql_queues::lifo_stack<idle_statement> idle;
+        std::atomic<std::uint32_t> allocated{0};
+
+        // the fewest cold handles the stack held since the last maintenance tick, the handles below that mark sat
+        // untouched at the bottom meanwhile, idle_lows keeps the marks of the last idle_ttl for the maintenance thread
+        std::atomic<std::size_t> idle_low{0};
+        std::deque<std::size_t> idle_lows;
+
+        // prepared handles, least recently used at the front
+        std::mutex prepared_mtx;
+        std::list<pooled_statement> prepared;
+        std::unordered_multimap<std::string_view, std::list<pooled_statement>::iterator> prepared_index;
+        std::atomic<std::size_t> prepared_count{0};
+
+        // handles of this shard parked in thread caches
+        std::atomic<std::size_t> cached{0};
+
+        pool_shard(database_connection& conn, std::uint32_t shard_index, std::size_t capacity) : connection(conn), index(shard_index), idle(capacity) {
+            h_dbc = static_cast<SQLHDBC>(get_dbc_handle(conn));
+        }
+
+        // handles in use, those parked in thread caches are idle as well
+        std::size_t load() const {
+            std::size_t parked = idle.size_approx() + prepared_count.load(std::memory_order_relaxed) + cached.load(std::memory_order_relaxed);
+            std::size_t count = allocated.load(std::memory_order_relaxed);
+            return count > parked ? count - parked : 0;
+        }
+
+        // after a pop from idle
+        void note_idle_size() {
+            std::size_t size = idle.size_approx();
+            std::size_t low = idle_low.load(std::memory_order_relaxed);
+            while (size < low && !idle_low.compare_exchange_weak(low, size, std::memory_order_relaxed)) {}
+        }
+
+        // the index is keyed by views into the list entries so it is cleared before an entry is moved out, requires prepared_mtx
+        pooled_statement take_prepared(std::list<pooled_statement>::iterator node) {
+            auto range = prepared_index.equal_range(node->sql);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (it->second == node) {
+                    prepared_index.erase(it);
+                    break;
+                }
+            }
+
+            pooled_statement ps = std::move(*node);
+            prepared.erase(node);
+            prepared_count.fetch_sub(1, std::memory_order_relaxed);
+            ps.shard = index;
+            return ps;
+        }
+    };
+
+    struct statement_pool::pool {
         statement_pool::alloc_options pool_opts;
         statement::alloc_options stmt_opts;
+
+        // one shard per connection, the totals are enforced across all of them
+        std::vector<std::unique_ptr<pool_shard>> shards;
+        std::atomic<std::uint32_t> total_allocated{0};
+
+        // an exhausted acquire queues on the stack of its own thread, releasers hand handles to the queue heads
+        // directly so a new arrival cannot overtake them, everything below is guarded by mtx except the count
+        struct waiter {
+            std::string_view sql;
+            std::condition_variable cvar;
+            pooled_statement handed{};
+            bool served{false};
+        };
+
         std::mutex mtx;
-        std::condition_variable cvar;
-        std::uint8_t total_allocated = 0;
+        std::array<std::deque<waiter*>, statement_pool::priority_count> wait_queues;
+        std::array<statement_pool::wait_stats, statement_pool::priority_count> wait_history{};
+        std::atomic<std::uint32_t> waiters{0};
+
+        // per-thread caches in front of the shared structures, a slot is used by its thread, other threads claim it
+        // through the state when the pool runs dry, when the maintenance trims it or when the pool is torn down
+        static constexpr std::uint8_t slot_empty = 0;
+        static constexpr std::uint8_t slot_busy = 1;
+        static constexpr std::uint8_t slot_full = 2;
+
+        struct local_slot {
+            std::atomic<std::uint8_t> state{slot_empty};
+            pooled_statement entry{};
+        };
+
+        struct local_cache {
+            std::atomic<pool*> owner{nullptr};
+            std::mutex retire_mtx;
+            std::array<local_slot, simql_constants::limits::max_thread_statement_cache_size> slots{};
+        };
+
+        // hands every cached handle back to its pool when the thread exits
+        struct thread_caches {
+            std::vector<std::shared_ptr<local_cache>> caches;
+            ~thread_caches() {
+                for (std::shared_ptr<local_cache>& cache : caches)
+                    retire(*cache);
+            }
+        };
 
-        pool(database_connection& conn, const statement_pool::alloc_options& pool_options, const statement::alloc_options& stmt_options) : connection(conn), pool_opts(pool_options) {
-            h_dbc = static_cast<SQLHDBC>(get_dbc_handle(conn));
+        std::mutex caches_mtx;
+        std::vector<std::shared_ptr<local_cache>> caches;
+
+        // background maintenance, acquires that found the pool empty since the last tick feed the demand estimate
+        // unless the maintenance was freeing idle handles at the time
+        std::thread maintenance;
+        std::mutex maintenance_mtx;
+        std::condition_variable maintenance_cvar;
+        bool stopping{false};
+        std::atomic<std::uint32_t> demand_misses{0};
+        std::atomic<bool> trimming{false};
 
+        pool(const std::vector<std::reference_wrapper<database_connection>>& connections, const statement_pool::alloc_options& pool_options, const statement::alloc_options& stmt_options) {
             stmt_opts = stmt_options;
             pool_opts = pool_options;
             if (pool_opts.min_size < simql_constants::limits::min_statement_handle_pool_size)
@@ -49,55 +185,186 @@ namespace simql {
             if (pool_opts.max_size > simql_constants::limits::max_statement_handle_pool_size)
                 pool_opts.max_size = simql_constants::limits::max_statement_handle_pool_size;
 
+            if (pool_opts.max_per_connection == 0 || pool_opts.max_per_connection > simql_constants::limits::max_statement_handles_per_connection)
+                pool_opts.max_per_connection = simql_constants::limits::max_statement_handles_per_connection;
+
+            if (pool_opts.min_per_connection > pool_opts.max_per_connection)
+                pool_opts.min_per_connection = pool_opts.max_per_connection;
+
+            if (pool_opts.thread_cache_size > simql_constants::limits::max_thread_statement_cache_size)
+                pool_opts.thread_cache_size = simql_constants::limits::max_thread_statement_cache_size;
+
+            shards.reserve(connections.size());
+            for (database_connection& conn : connections)
+                shards.push_back(std::make_unique<pool_shard>(conn, static_cast<std::uint32_t>(shards.size()), shard_capacity()));
+
             if (pool_options.min_size > 0)
                 build_pool(pool_options.min_size);
+
+            if (pool_opts.maintenance_interval.count() > 0)
+                maintenance = std::thread([this]() { maintain(); });
         }
 
         ~pool() {
-            for (pooled_statement& ps : statements) {
-                if (ps.h_stmt)
-                    SQLFreeHandle(SQL_HANDLE_STMT, ps.h_stmt);
-            }
-            statements.clear();
-        }
-
-        void build_pool(const std::uint8_t& target) {
-            while (total_allocated < target) {
-                SQLHSTMT h = SQL_NULL_HSTMT;
-                if (SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_STMT, h_dbc, &h))) {
-                    configure_stmt(h);
-                    total_allocated++;
-                    statements.push_back(pooled_statement {
-                        h,
-                        std::chrono::steady_clock::now()
-                    });
+
+            // the maintenance thread allocates and frees handles so it stops first
+            {
+                std::lock_guard<std::mutex> lock(maintenance_mtx);
+                stopping = true;
+            }
+            maintenance_cvar.notify_all();
+            if (maintenance.joinable())
+                maintenance.join();
+
+            // claim whatever other threads still cache so no handle outlives the pool
+            std::vector<std::shared_ptr<local_cache>> registered;
+            {
+                std::lock_guard<std::mutex> lock(caches_mtx);
+                registered.swap(caches);
+            }
+            for (std::shared_ptr<local_cache>& cache : registered) {
+                std::lock_guard<std::mutex> lock(cache->retire_mtx);
+                cache->owner.store(nullptr, std::memory_order_release);
+                for (local_slot& slot : cache->slots) {
+                    pooled_statement ps;
+                    if (take_slot(slot, ps))
+                        free_handle(*shards[ps.shard], ps.h_stmt);
+                }
+            }
+
+            for (std::unique_ptr<pool_shard>& shard : shards) {
+                idle_statement is;
+                while (shard->idle.try_pop(is))
+                    free_handle(*shard, is.h_stmt);
+
+                for (pooled_statement& ps : shard->prepared) {
+                    if (ps.h_stmt)
+                        free_handle(*shard, ps.h_stmt);
                 }
+                shard->prepared_index.clear();
+                shard->prepared.clear();
             }
         }
 
-        void configure_stmt(SQLHSTMT h) {
+        // every handle a shard may own fits in its ring
+        std::size_t shard_capacity() const {
+            if (pool_opts.max_size == 0)
+                return pool_opts.max_per_connection;
+
+            return std::min(pool_opts.max_size, pool_opts.max_per_connection);
+        }
+
+        // spreads a pool-wide size over the connections, each keeps its own floor and cap
+        std::uint32_t shard_target(std::size_t total) const {
+            std::size_t share = (total + shards.size() - 1) / shards.size();
+            share = std::max<std::size_t>(share, pool_opts.min_per_connection);
+            return static_cast<std::uint32_t>(std::min<std::size_t>(share, pool_opts.max_per_connection));
+        }
+
+        // the connection with the fewest handles out
+        std::size_t least_loaded() const {
+            std::size_t best{0};
+            std::size_t best_load = std::numeric_limits<std::size_t>::max();
+            for (std::size_t i = 0; i < shards.size(); i++) {
+                std::size_t load = shards[i]->load();
+                if (load < best_load) {
+                    best = i;
+                    best_load = load;
+                }
+            }
+            return best;
+        }
+
+        std::size_t shard_index(const database_connection* conn) const {
+            for (std::size_t i = 0; i < shards.size(); i++) {
+                if (&shards[i]->connection == conn)
+                    return i;
+            }
+            return shards.size();
+        }
+
+        // the statement of an exhausted acquire still reports against a connection of the pool
+        database_connection* connection_for(const pooled_statement& ps) const {
+            if (shards.empty())
+                return nullptr;
+
+            return &shards[ps.h_stmt ? ps.shard : least_loaded()]->connection;
+        }
+
+        bool fill(pool_shard& shard, std::uint32_t target, std::chrono::steady_clock::time_point now) {
+            bool added{false};
+            while (shard.allocated.load(std::memory_order_relaxed) < target) {
+                simql_types::cursor_attributes cursor;
+                SQLHSTMT h = allocate(shard, cursor);
+                if (!h)
+                    break;
+
+                if (!shard.idle.try_push(idle_statement{h, now, cursor})) {
+                    free_handle(shard, h);
+                    break;
+                }
+                added = true;
+            }
+            return added;
+        }
+
+        void build_pool(std::size_t target) {
+            if (shards.empty())
+                return;
+
+            std::uint32_t per_shard = shard_target(target);
+            for (std::unique_ptr<pool_shard>& shard : shards)
+                fill(*shard, per_shard, std::chrono::steady_clock::now());
+        }
+
+        // a fresh HSTMT starts at the ODBC defaults, only attributes that differ from them are sent to the driver, a handle
+        // that refuses one is not pooled, a cursor attribute the driver substituted a value for (01S02) is read back here
+        // once and travels with the handle
+        bool configure_stmt(SQLHSTMT h, simql_types::cursor_attributes& cursor) {
+            cursor = simql_types::cursor_attributes{stmt_opts.rowset_size, stmt_opts.is_scrollable};
+
 
             // set query timeout
-            SQLPOINTER p_query_timeout = reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(stmt_opts.query_timeout));
-            SQLSetStmtAttrW(h, SQL_ATTR_QUERY_TIMEOUT, p_query_timeout, SQL_IS_INTEGER);
+            if (stmt_opts.query_timeout != 0) {
+                SQLPOINTER p_query_timeout = reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(stmt_opts.query_timeout));
+                if (!SQL_SUCCEEDED(SQLSetStmtAttrW(h, SQL_ATTR_QUERY_TIMEOUT, p_query_timeout, SQL_IS_INTEGER)))
+                    return false;
+            }
 
             // set max rows
-            SQLPOINTER p_max_rows = reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(stmt_opts.max_rows));
-            SQLSetStmtAttrW(h, SQL_ATTR_MAX_ROWS, p_max_rows, SQL_IS_INTEGER);
+            if (stmt_opts.max_rows != 0) {
+                SQLPOINTER p_max_rows = reinterpret_cast<SQLPOINTER>(static_cast<SQLULEN>(stmt_opts.max_rows));
+                if (!SQL_SUCCEEDED(SQLSetStmtAttrW(h, SQL_ATTR_MAX_ROWS, p_max_rows, SQL_IS_INTEGER)))
+                    return false;
+            }
 
             // set rowset size
-            SQLPOINTER p_rowset_size = reinterpret_cast<SQLPOINTER>(static_cast<SQLUINTEGER>(stmt_opts.rowset_size));
-            SQLSetStmtAttrW(h, SQL_ATTR_ROW_ARRAY_SIZE, p_rowset_size, SQL_IS_INTEGER);
+            if (stmt_opts.rowset_size > 1) {
+                SQLPOINTER p_rowset_size = reinterpret_cast<SQLPOINTER>(static_cast<SQLUINTEGER>(stmt_opts.rowset_size));
+                SQLRETURN rc = SQLSetStmtAttrW(h, SQL_ATTR_ROW_ARRAY_SIZE, p_rowset_size, SQL_IS_INTEGER);
+                if (!SQL_SUCCEEDED(rc))
+                    return false;
+
+                SQLULEN rowset_size{0};
+                if (rc == SQL_SUCCESS_WITH_INFO && SQL_SUCCEEDED(SQLGetStmtAttrW(h, SQL_ATTR_ROW_ARRAY_SIZE, &rowset_size, SQL_IS_UINTEGER, nullptr)) && rowset_size > 0)
+                    cursor.rowset_size = static_cast<std::uint32_t>(rowset_size);
+            }
 
             // set cursor scrollability
-            SQLPOINTER p_is_scrollable = stmt_opts.is_scrollable ? reinterpret_cast<SQLPOINTER>(SQL_SCROLLABLE) : reinterpret_cast<SQLPOINTER>(SQL_NONSCROLLABLE);
-            SQLSetStmtAttrW(h, SQL_ATTR_CURSOR_SCROLLABLE, p_is_scrollable, SQL_IS_INTEGER);
+            if (stmt_opts.is_scrollable) {
+                SQLRETURN rc = SQLSetStmtAttrW(h, SQL_ATTR_CURSOR_SCROLLABLE, reinterpret_cast<SQLPOINTER>(SQL_SCROLLABLE), SQL_IS_INTEGER);
+                if (!SQL_SUCCEEDED(rc))
+                    return false;
+
+                SQLULEN scrollable{SQL_SCROLLABLE};
+                if (rc == SQL_SUCCESS_WITH_INFO && SQL_SUCCEEDED(SQLGetStmtAttrW(h, SQL_ATTR_CURSOR_SCROLLABLE, &scrollable, SQL_IS_UINTEGER, nullptr)))
+                    cursor.is_scrollable = scrollable == SQL_SCROLLABLE;
+            }
 
             // set cursor sensitivity
-            SQLPOINTER p_cursor_sensitivity;
+            SQLPOINTER p_cursor_sensitivity{nullptr};
             switch (stmt_opts.sensitivity) {
             case statement::cursor_sensitivity::unspecified:
-                p_cursor_sensitivity = reinterpret_cast<SQLPOINTER>(SQL_UNSPECIFIED);
                 break;
             case statement::cursor_sensitivity::sensitive:
                 p_cursor_sensitivity = reinterpret_cast<SQLPOINTER>(SQL_SENSITIVE);
@@ -106,109 +373,605 @@ namespace simql {
                 p_cursor_sensitivity = reinterpret_cast<SQLPOINTER>(SQL_INSENSITIVE);
                 break;
             }
-            SQLSetStmtAttrW(h, SQL_ATTR_CURSOR_SENSITIVITY, p_cursor_sensitivity, SQL_IS_INTEGER);
+            if (p_cursor_sensitivity && !SQL_SUCCEEDED(SQLSetStmtAttrW(h, SQL_ATTR_CURSOR_SENSITIVITY, p_cursor_sensitivity, SQL_IS_INTEGER)))
+                return false;
+
+            return true;
         }
 
-        SQLHSTMT acquire() {
-            std::unique_lock<std::mutex> lock(mtx);
+        // claims one slot below the limit so concurrent callers cannot overshoot it, a limit of 0 is unbounded
+        static bool reserve(std::atomic<std::uint32_t>& counter, std::uint32_t limit) {
+            std::uint32_t current = counter.load(std::memory_order_relaxed);
+            do {
+                if (limit > 0 && current >= limit)
+                    return false;
+            } while (!counter.compare_exchange_weak(current, current + 1, std::memory_order_relaxed));
+            return true;
+        }
 
-            auto try_pop = [&]() -> SQLHSTMT {
-                if (!statements.empty()) {
-                    SQLHSTMT h = statements.back().h_stmt;
-                    statements.pop_back();
-                    return h;
-                }
+        // claims a slot of max_size and one of max_per_connection before allocating
+        SQLHSTMT allocate(pool_shard& shard, simql_types::cursor_attributes& cursor) {
+            if (!reserve(total_allocated, pool_opts.max_size))
                 return SQL_NULL_HSTMT;
-            };
 
-            if (auto h = try_pop())
-                return h;
+            if (!reserve(shard.allocated, pool_opts.max_per_connection)) {
+                total_allocated.fetch_sub(1, std::memory_order_relaxed);
+                return SQL_NULL_HSTMT;
+            }
 
-            if (pool_opts.max_size == 0 || total_allocated < pool_opts.max_size) {
-                lock.unlock();
-                SQLHSTMT h = SQL_NULL_HSTMT;
-                if (SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_STMT, h_dbc, &h))) {
-                    configure_stmt(h);
-                    lock.lock();
-                    total_allocated++;
-                    return h;
+            SQLHSTMT h = SQL_NULL_HSTMT;
+            if (!SQL_SUCCEEDED(simql_metrics::timed(simql_metrics::timer::odbc_alloc_handle, [&]() { return SQLAllocHandle(SQL_HANDLE_STMT, shard.h_dbc, &h); }))) {
+                shard.allocated.fetch_sub(1, std::memory_order_relaxed);
+                total_allocated.fetch_sub(1, std::memory_order_relaxed);
+                return SQL_NULL_HSTMT;
+            }
+            simql_metrics::add(simql_metrics::counter::handles_allocated);
+
+            if (!configure_stmt(h, cursor)) {
+                free_handle(shard, h);
+                return SQL_NULL_HSTMT;
+            }
+            return h;
+        }
+
+        void free_handle(pool_shard& shard, SQLHSTMT h) {
+            SQLFreeHandle(SQL_HANDLE_STMT, h);
+            simql_metrics::add(simql_metrics::counter::handles_freed);
+            shard.allocated.fetch_sub(1, std::memory_order_relaxed);
+            total_allocated.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        // a prepared handle that is handed out for other SQL loses its column bindings first
+        static void unprepare(pooled_statement& ps) {
+            if (ps.sql.empty())
+                return;
+
+            SQLFreeStmt(ps.h_stmt, SQL_UNBIND);
+            ps.plan.reset();
+            ps.sql.clear();
+        }
+
+        bool take_slot(local_slot& slot, pooled_statement& ps) {
+            std::uint8_t expected = slot_full;
+            if (!slot.state.compare_exchange_strong(expected, slot_busy, std::memory_order_acquire))
+                return false;
+
+            ps = std::move(slot.entry);
+            slot.entry = pooled_statement{};
+            slot.state.store(slot_empty, std::memory_order_release);
+            shards[ps.shard]->cached.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        bool put_slot(local_slot& slot, pooled_statement& ps) {
+            std::uint8_t expected = slot_empty;
+            if (!slot.state.compare_exchange_strong(expected, slot_busy, std::memory_order_acquire))
+                return false;
+
+            shards[ps.shard]->cached.fetch_add(1, std::memory_order_relaxed);
+            slot.entry = std::move(ps);
+            slot.state.store(slot_full, std::memory_order_release);
+            return true;
+        }
+
+        static void retire(local_cache& cache) {
+            std::lock_guard<std::mutex> lock(cache.retire_mtx);
+            pool* owner = cache.owner.exchange(nullptr, std::memory_order_acq_rel);
+            if (!owner)
+                return;
+
+            for (local_slot& slot : cache.slots) {
+                pooled_statement ps;
+                if (owner->take_slot(slot, ps))
+                    owner->release_shared(std::move(ps));
+            }
+
+            std::lock_guard<std::mutex> caches_lock(owner->caches_mtx);
+            std::erase_if(owner->caches, [&cache](const std::shared_ptr<local_cache>& registered) { return registered.get() == &cache; });
+        }
+
+        // registers the calling thread's cache on first use, entries of destroyed pools are dropped on the way
+        local_cache& local_cache_for_thread() {
+            static thread_local thread_caches t_caches;
+            for (auto it = t_caches.caches.begin(); it != t_caches.caches.end();) {
+                pool* owner = (*it)->owner.load(std::memory_order_acquire);
+                if (owner == this)
+                    return **it;
+
+                if (!owner)
+                    it = t_caches.caches.erase(it);
+                else
+                    ++it;
+            }
+
+            auto cache = std::make_shared<local_cache>();
+            cache->owner.store(this, std::memory_order_release);
+            {
+                std::lock_guard<std::mutex> lock(caches_mtx);
+                caches.push_back(cache);
+            }
+            t_caches.caches.push_back(cache);
+            return *cache;
+        }
+
+        // an exact match is a handle with the same SQL prepared, or a cold handle when no SQL is given
+        pooled_statement acquire_local(std::string_view sql, bool exact) {
+            pooled_statement ps;
+            if (pool_opts.thread_cache_size == 0)
+                return ps;
+
+            local_cache& cache = local_cache_for_thread();
+            for (std::uint8_t i = 0; i < pool_opts.thread_cache_size; i++) {
+                local_slot& slot = cache.slots[i];
+                std::uint8_t expected = slot_full;
+                if (!slot.state.compare_exchange_strong(expected, slot_busy, std::memory_order_acquire))
+                    continue;
+
+                if (exact && slot.entry.sql != sql) {
+                    slot.state.store(slot_full, std::memory_order_release);
+                    continue;
+                }
+
+                ps = std::move(slot.entry);
+                slot.entry = pooled_statement{};
+                slot.state.store(slot_empty, std::memory_order_release);
+                shards[ps.shard]->cached.fetch_sub(1, std::memory_order_relaxed);
+                return ps;
+            }
+            return ps;
+        }
+
+        // a handle parked in another thread's cache is taken over rather than waited for
+        pooled_statement claim_cached(std::string_view sql) {
+            if (pool_opts.thread_cache_size == 0)
+                return pooled_statement{};
+
+            std::lock_guard<std::mutex> lock(caches_mtx);
+            for (std::shared_ptr<local_cache>& cache : caches) {
+                for (std::uint8_t i = 0; i < pool_opts.thread_cache_size; i++) {
+                    pooled_statement ps;
+                    if (!take_slot(cache->slots[i], ps))
+                        continue;
+
+                    if (ps.sql != sql)
+                        unprepare(ps);
+                    return ps;
+                }
+            }
+            return pooled_statement{};
+        }
+
+        // a full cache hands all of its handles back to the shared pool in one go and keeps the newest
+        bool release_local(pooled_statement& ps) {
+            if (pool_opts.thread_cache_size == 0)
+                return false;
+
+            local_cache& cache = local_cache_for_thread();
+            for (std::uint8_t i = 0; i < pool_opts.thread_cache_size; i++) {
+                if (put_slot(cache.slots[i], ps))
+                    return true;
+            }
+
+            for (std::uint8_t i = 0; i < pool_opts.thread_cache_size; i++) {
+                pooled_statement evicted;
+                if (take_slot(cache.slots[i], evicted))
+                    release_shared(std::move(evicted));
+            }
+            return put_slot(cache.slots[0], ps);
+        }
+
+        // prefers a handle with the same SQL prepared, then a cold handle, then the least recently used prepared handle,
+        // each step visits the connections starting with the least loaded one
+        pooled_statement try_pop(std::string_view sql) {
+            std::size_t start = least_loaded();
+            std::size_t count = shards.size();
+
+            if (!sql.empty()) {
+                for (std::size_t i = 0; i < count; i++) {
+                    pool_shard& shard = *shards[(start + i) % count];
+                    if (shard.prepared_count.load(std::memory_order_relaxed) == 0)
+                        continue;
+
+                    std::lock_guard<std::mutex> lock(shard.prepared_mtx);
+                    auto it = shard.prepared_index.find(sql);
+                    if (it != shard.prepared_index.end())
+                        return shard.take_prepared(it->second);
                 }
-                lock.lock();
             }
 
-            if (pool_opts.acquire_timeout.count() > 0) {
-                auto deadline = std::chrono::steady_clock::now() + pool_opts.acquire_timeout;
-                while (true) {
-                    if (auto h = try_pop())
-                        return h;
+            for (std::size_t i = 0; i < count; i++) {
+                pool_shard& shard = *shards[(start + i) % count];
+                idle_statement is;
+                if (shard.idle.try_pop(is)) {
+                    shard.note_idle_size();
+                    return pooled_statement{is.h_stmt, is.last_used, {}, {}, shard.index, is.cursor};
+                }
+            }
 
-                    if (cvar.wait_until(lock, deadline) == std::cv_status::timeout)
-                        break;
+            for (std::size_t i = 0; i < count; i++) {
+                pool_shard& shard = *shards[(start + i) % count];
+                if (shard.prepared_count.load(std::memory_order_relaxed) == 0)
+                    continue;
+
+                std::lock_guard<std::mutex> lock(shard.prepared_mtx);
+                if (!shard.prepared.empty()) {
+                    pooled_statement ps = shard.take_prepared(shard.prepared.begin());
+                    unprepare(ps);
+                    return ps;
                 }
             }
 
-            return try_pop();
+            return pooled_statement{};
         }
 
-        void release(SQLHSTMT h) {
-            if (!h)
-                return;
+        pooled_statement allocate_least_loaded() {
+            std::size_t start = least_loaded();
+            for (std::size_t i = 0; i < shards.size(); i++) {
+                pool_shard& shard = *shards[(start + i) % shards.size()];
+                simql_types::cursor_attributes cursor;
+                if (SQLHSTMT h = allocate(shard, cursor))
+                    return pooled_statement{h, {}, {}, {}, shard.index, cursor};
+            }
+            return pooled_statement{};
+        }
+
+        pooled_statement acquire(std::string_view sql, statement_pool::priority prio, std::chrono::steady_clock::time_point deadline) {
+            if (pooled_statement ps = acquire_local(sql, true); ps.h_stmt) {
+                simql_metrics::add(simql_metrics::counter::pool_hits);
+                return ps;
+            }
+
+            if (pooled_statement ps = try_pop(sql); ps.h_stmt) {
+                simql_metrics::add(simql_metrics::counter::pool_hits);
+                return ps;
+            }
+
+            if (!trimming.load(std::memory_order_relaxed))
+                demand_misses.fetch_add(1, std::memory_order_relaxed);
+            simql_metrics::add(simql_metrics::counter::pool_misses);
+
+            // rather repurpose a handle this thread holds than allocate or wait
+            if (pooled_statement ps = acquire_local(sql, false); ps.h_stmt) {
+                if (ps.sql != sql)
+                    unprepare(ps);
+                return ps;
+            }
+
+            if (pooled_statement ps = allocate_least_loaded(); ps.h_stmt)
+                return ps;
 
-            SQLFreeStmt(h, SQL_CLOSE);
-            SQLFreeStmt(h, SQL_RESET_PARAMS);
-            SQLFreeStmt(h, SQL_UNBIND);
+            if (pooled_statement ps = claim_cached(sql); ps.h_stmt)
+                return ps;
+
+            simql_metrics::add(simql_metrics::counter::pool_exhausted);
+            if (std::chrono::steady_clock::now() >= deadline)
+                return pooled_statement{};
+
+            return wait(sql, prio, deadline);
+        }
+
+        // --------------------------------------------------
+        // WAITING
+        // --------------------------------------------------
+
+        static std::size_t depth_bucket(std::size_t depth) {
+            return std::min<std::size_t>(std::bit_width(depth), statement_pool::depth_bucket_count - 1);
+        }
+
+        static std::size_t wait_bucket(std::chrono::steady_clock::duration waited) {
+            const auto& bounds = statement_pool::wait_time_bounds;
+            return static_cast<std::size_t>(std::lower_bound(bounds.begin(), bounds.end(), waited) - bounds.begin());
+        }
+
+        // requires mtx
+        waiter* front_waiter() {
+            for (std::deque<waiter*>& queue : wait_queues) {
+                if (!queue.empty())
+                    return queue.front();
+            }
+            return nullptr;
+        }
+
+        // requires mtx, w has to be the front_waiter
+        void serve(waiter& w, pooled_statement ps) {
+            for (std::deque<waiter*>& queue : wait_queues) {
+                if (!queue.empty() && queue.front() == &w) {
+                    queue.pop_front();
+                    break;
+                }
+            }
+
+            if (ps.sql != w.sql)
+                unprepare(ps);
+
+            w.handed = std::move(ps);
+            w.served = true;
+            waiters.fetch_sub(1);
+            w.cvar.notify_one();
+        }
+
+        // requires mtx, hands whatever the shared pool and the thread caches hold to the queue heads in order
+        void serve_waiters() {
+            while (waiter* w = front_waiter()) {
+                pooled_statement ps = try_pop(w->sql);
+                if (!ps.h_stmt)
+                    ps = claim_cached(w->sql);
+                if (!ps.h_stmt)
+                    break;
+
+                serve(*w, std::move(ps));
+            }
+        }
+
+        // a waiter whose deadline passes leaves the queue on its own, nobody has to wake it
+        pooled_statement wait(std::string_view sql, statement_pool::priority prio, std::chrono::steady_clock::time_point deadline) {
+            std::size_t cls = std::min<std::size_t>(static_cast<std::size_t>(prio), statement_pool::priority_count - 1);
+            auto begin = std::chrono::steady_clock::now();
+            waiter w;
+            w.sql = sql;
 
             std::unique_lock<std::mutex> lock(mtx);
-            if (pool_opts.idle_ttl.count() > 0 && total_allocated > pool_opts.min_size) {
-                auto now = std::chrono::steady_clock::now();
-
-                while (!statements.empty() && total_allocated > pool_opts.min_size) {
-                    const auto& oldest = statements.front();
-                    if (now - oldest.last_used >= pool_opts.idle_ttl) {
-                        SQLFreeHandle(SQL_HANDLE_STMT, oldest.h_stmt);
-                        statements.pop_front();
-                        total_allocated--;
-                    } else {
-                        break;
+            std::deque<waiter*>& queue = wait_queues[cls];
+            statement_pool::wait_stats& stats = wait_history[cls];
+            stats.depth_buckets[depth_bucket(queue.size())]++;
+            queue.push_back(&w);
+
+            // pairs with the fence in notify_waiters, a handle parked before the count was visible is picked up here
+            waiters.fetch_add(1);
+            serve_waiters();
+
+            if (!w.cvar.wait_until(lock, deadline, [&w]() { return w.served; })) {
+                std::erase(queue, &w);
+                waiters.fetch_sub(1);
+                stats.timed_out++;
+                return pooled_statement{};
+            }
+
+            stats.served++;
+            stats.wait_buckets[wait_bucket(std::chrono::steady_clock::now() - begin)]++;
+            return std::move(w.handed);
+        }
+
+        std::array<statement_pool::wait_stats, statement_pool::priority_count> wait_statistics() {
+            std::lock_guard<std::mutex> lock(mtx);
+            std::array<statement_pool::wait_stats, statement_pool::priority_count> stats = wait_history;
+            for (std::size_t i = 0; i < statement_pool::priority_count; i++)
+                stats[i].queue_depth = wait_queues[i].size();
+            return stats;
+        }
+
+        // --------------------------------------------------
+        // MAINTENANCE
+        // --------------------------------------------------
+
+        void maintain() {
+            std::deque<std::size_t> demand_window;
+            std::unique_lock<std::mutex> lock(maintenance_mtx);
+            while (!maintenance_cvar.wait_for(lock, pool_opts.maintenance_interval, [this]() { return stopping; })) {
+                lock.unlock();
+                run_maintenance(demand_window);
+                lock.lock();
+            }
+        }
+
+        // sizes the pool for the peak demand seen within demand_window, never below min_size or above max_size,
+        // and spreads the target evenly over the connections
+        void run_maintenance(std::deque<std::size_t>& demand_window) {
+            if (shards.empty())
+                return;
+
+            auto now = std::chrono::steady_clock::now();
+
+            std::size_t in_use{0};
+            for (std::unique_ptr<pool_shard>& shard : shards)
+                in_use += shard->load();
+            demand_window.push_back(in_use + demand_misses.exchange(0, std::memory_order_relaxed));
+
+            std::size_t window_ticks = static_cast<std::size_t>(std::max<std::int64_t>(1, pool_opts.demand_window / pool_opts.maintenance_interval));
+            while (demand_window.size() > window_ticks)
+                demand_window.pop_front();
+
+            std::size_t target = std::max<std::size_t>(pool_opts.min_size, *std::max_element(demand_window.begin(), demand_window.end()));
+            if (pool_opts.max_size > 0)
+                target = std::min<std::size_t>(target, pool_opts.max_size);
+
+            // pre-warm so a ramp finds handles waiting instead of allocating on the request path
+            std::uint32_t per_shard = shard_target(target);
+            bool added{false};
+            for (std::unique_ptr<pool_shard>& shard : shards)
+                added = fill(*shard, per_shard, now) || added;
+
+            if (added)
+                notify_waiters();
+
+            if (pool_opts.idle_ttl.count() > 0) {
+                trim_cached(now, per_shard);
+                for (std::unique_ptr<pool_shard>& shard : shards)
+                    trim_expired(*shard, now, per_shard);
+            }
+        }
+
+        // a thread that stopped acquiring would otherwise keep its cached handles past idle_ttl, live ones go back
+        // to their slot or, when the thread refilled it meanwhile, to the shared pool
+        void trim_cached(std::chrono::steady_clock::time_point now, std::size_t floor) {
+            if (pool_opts.thread_cache_size == 0)
+                return;
+
+            std::vector<pooled_statement> expired;
+            std::vector<pooled_statement> displaced;
+            {
+                std::lock_guard<std::mutex> lock(caches_mtx);
+                for (std::shared_ptr<local_cache>& cache : caches) {
+                    for (std::uint8_t i = 0; i < pool_opts.thread_cache_size; i++) {
+                        local_slot& slot = cache->slots[i];
+                        if (slot.state.load(std::memory_order_acquire) != slot_full)
+                            continue;
+
+                        pooled_statement ps;
+                        if (!take_slot(slot, ps))
+                            continue;
+
+                        pool_shard& shard = *shards[ps.shard];
+                        std::size_t pending = std::count_if(expired.begin(), expired.end(), [&ps](const pooled_statement& e) { return e.shard == ps.shard; });
+                        if (now - ps.last_used >= pool_opts.idle_ttl && shard.allocated.load(std::memory_order_relaxed) > floor + pending)
+                            expired.push_back(std::move(ps));
+                        else if (!put_slot(slot, ps))
+                            displaced.push_back(std::move(ps));
                     }
                 }
             }
 
-            statements.push_back(pooled_statement {
-                h,
-                std::chrono::steady_clock::now()
-            });
+            for (pooled_statement& ps : displaced)
+                release_shared(std::move(ps));
 
-            if (pool_opts.max_size > 0) {
-                while (total_allocated > pool_opts.max_size && !statements.empty()) {
-                    SQLFreeHandle(SQL_HANDLE_STMT, statements.front().h_stmt);
-                    statements.pop_front();
-                    total_allocated--;
+            for (pooled_statement& ps : expired)
+                free_handle(*shards[ps.shard], ps.h_stmt);
+        }
+
+        // collects idle handles past idle_ttl while the shard stays above the floor, SQLFreeHandle then runs outside every lock
+        void trim_expired(pool_shard& shard, std::chrono::steady_clock::time_point now, std::size_t floor) {
+            std::vector<pooled_statement> expired;
+            auto above_floor = [&]() { return shard.allocated.load(std::memory_order_relaxed) > floor + expired.size(); };
+
+            // the cold handles stay on the stack, those below the lowest mark of every tick within idle_ttl went
+            // unused that long, as many handles are popped off the top and freed, which one goes does not matter
+            std::size_t window_ticks = static_cast<std::size_t>(std::max<std::int64_t>(1, (pool_opts.idle_ttl + pool_opts.maintenance_interval - std::chrono::milliseconds(1)) / pool_opts.maintenance_interval));
+            shard.idle_lows.push_back(shard.idle_low.exchange(shard.idle.size_approx(), std::memory_order_relaxed));
+            while (shard.idle_lows.size() > window_ticks)
+                shard.idle_lows.pop_front();
+
+            if (shard.idle_lows.size() == window_ticks) {
+                std::size_t untouched = *std::min_element(shard.idle_lows.begin(), shard.idle_lows.end());
+                idle_statement is;
+                trimming.store(true, std::memory_order_relaxed);
+                while (expired.size() < untouched && above_floor() && shard.idle.try_pop(is)) {
+                    expired.push_back(pooled_statement{is.h_stmt, is.last_used});
+                    shard.note_idle_size();
                 }
+                trimming.store(false, std::memory_order_relaxed);
+
+                for (std::size_t& low : shard.idle_lows)
+                    low -= std::min(low, expired.size());
+            }
+
+            if (shard.prepared_count.load(std::memory_order_relaxed) > 0) {
+                std::lock_guard<std::mutex> lock(shard.prepared_mtx);
+                while (!shard.prepared.empty() && above_floor() && now - shard.prepared.front().last_used >= pool_opts.idle_ttl)
+                    expired.push_back(shard.take_prepared(shard.prepared.begin()));
+            }
+
+            for (pooled_statement& ps : expired)
+                free_handle(shard, ps.h_stmt);
+        }
+
+        // pairs with the registration in wait so either the waiter sees the handle or this sees the waiter
+        void notify_waiters() {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiters.load(std::memory_order_relaxed) > 0) {
+                std::lock_guard<std::mutex> lock(mtx);
+                serve_waiters();
+            }
+        }
+
+        // skips the shared pool entirely when someone is queued
+        bool hand_off(pooled_statement& ps) {
+            std::lock_guard<std::mutex> lock(mtx);
+            waiter* w = front_waiter();
+            if (!w)
+                return false;
+
+            serve(*w, std::move(ps));
+            return true;
+        }
+
+        // the statement has already closed its cursor and reset its parameters, prepared handles keep their column bindings
+        void release(pooled_statement ps) {
+            if (!ps.h_stmt)
+                return;
+
+            ps.last_used = std::chrono::steady_clock::now();
+
+            // waiting threads are served before the thread cache is refilled, the fence pairs with the registration
+            // in wait so a waiter that queued just now is seen here
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (waiters.load(std::memory_order_relaxed) > 0) {
+                if (hand_off(ps))
+                    return;
+            } else if (release_local(ps)) {
+
+                // a waiter that registered while the handle went into the cache is served from the cache
+                notify_waiters();
+                return;
             }
 
-            lock.unlock();
-            cvar.notify_one();
+            release_shared(std::move(ps));
+        }
+
+        void release_shared(pooled_statement ps) {
+            pool_shard& shard = *shards[ps.shard];
+            if (ps.sql.empty()) {
+                if (!shard.idle.try_push(idle_statement{ps.h_stmt, ps.last_used, ps.cursor}))
+                    free_handle(shard, ps.h_stmt);
+            } else {
+                std::lock_guard<std::mutex> lock(shard.prepared_mtx);
+                shard.prepared.push_back(std::move(ps));
+                auto node = std::prev(shard.prepared.end());
+                shard.prepared_index.emplace(std::string_view(node->sql), node);
+                shard.prepared_count.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            notify_waiters();
         }
 
     };
 
-    statement_pool::statement_pool(database_connection& conn, const statement_pool::alloc_options& pool_options, const statement::alloc_options& stmt_options) : m_pool(std::make_unique<pool>(conn, pool_options, stmt_options)), m_conn(conn) {}
+    statement_pool::statement_pool(database_connection& conn, const statement_pool::alloc_options& pool_options, const statement::alloc_options& stmt_options) : statement_pool(std::vector<std::reference_wrapper<database_connection>>{conn}, pool_options, stmt_options) {}
+    statement_pool::statement_pool(const std::vector<std::reference_wrapper<database_connection>>& connections, const statement_pool::alloc_options& pool_options, const statement::alloc_options& stmt_options) : m_pool(std::make_unique<pool>(connections, pool_options, stmt_options)) {}
     statement_pool::~statement_pool() = default;
 
     void statement_pool::build_pool() {
-        std::lock_guard<std::mutex> lock(m_pool.get()->mtx);
         m_pool.get()->build_pool(m_pool.get()->pool_opts.min_size);
     }
 
     statement statement_pool::acquire() {
-        SQLHSTMT h_stmt = m_pool.get()->acquire();
-        return statement(std::move(h_stmt), m_conn, m_pool.get());
+        return acquire(priority::normal, std::chrono::steady_clock::now() + m_pool.get()->pool_opts.acquire_timeout);
+    }
+
+    statement statement_pool::acquire(priority prio, std::chrono::steady_clock::time_point deadline) {
+        pooled_statement ps = simql_metrics::timed(simql_metrics::timer::acquire_wait, [&]() { return m_pool.get()->acquire(std::string_view{}, prio, deadline); });
+        return statement(ps.h_stmt, m_pool.get()->connection_for(ps), m_pool.get(), m_pool.get()->stmt_opts, ps.cursor);
+    }
+
+    statement statement_pool::acquire(std::string_view sql) {
+        return acquire(sql, priority::normal, std::chrono::steady_clock::now() + m_pool.get()->pool_opts.acquire_timeout);
+    }
+
+    statement statement_pool::acquire(std::string_view sql, priority prio, std::chrono::steady_clock::time_point deadline) {
+        pooled_statement ps = simql_metrics::timed(simql_metrics::timer::acquire_wait, [&]() { return m_pool.get()->acquire(sql, prio, deadline); });
+        return statement(ps.h_stmt, m_pool.get()->connection_for(ps), m_pool.get(), m_pool.get()->stmt_opts, ps.cursor, sql, std::move(ps.plan));
     }
 
     void statement_pool::release(statement&& stmt) {
-        SQLHSTMT h_stmt = stmt.detach_handle();
-        m_pool.get()->release(h_stmt);
+        pooled_statement ps;
+        database_connection* conn{nullptr};
+        ps.h_stmt = static_cast<SQLHSTMT>(stmt.detach_handle(ps.sql, ps.plan, conn, ps.cursor));
+        if (!ps.h_stmt)
+            return;
+
+        // a handle of another pool's connection cannot be parked here
+        std::size_t index = m_pool.get()->shard_index(conn);
+        if (index == m_pool.get()->shards.size()) {
+            SQLFreeHandle(SQL_HANDLE_STMT, ps.h_stmt);
+            simql_metrics::add(simql_metrics::counter::handles_freed);
+            return;
+        }
+
+        ps.shard = static_cast<std::uint32_t>(index);
+        m_pool.get()->release(std::move(ps));
+    }
+
+    std::array<statement_pool::wait_stats, statement_pool::priority_count> statement_pool::wait_statistics() {
+        return m_pool.get()->wait_statistics();
     }
 
 }
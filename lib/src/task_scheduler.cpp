@@ -0,0 +1,301 @@
+// SimQL stuff
+#include "task_scheduler.hpp"
+#include "connection_pool.hpp"
+#include "database_connection.hpp"
+#include "simql_strings.hpp"
+
+// STL stuff
+#include <cstdint>
+#include <memory>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <string>
+#include <functional>
+#include <utility>
+
+namespace simql {
+
+    // shared by a submitted task and its continuations, the last of them to finish reports the result
+    struct task_scheduler::task_state {
+        std::atomic<std::uint64_t> outstanding{1};
+        std::atomic<std::uint64_t> tasks{0};
+        std::mutex mtx;
+        bool ok{true};
+        std::string error{};
+        task_scheduler::completion done{};
+        std::chrono::steady_clock::time_point submitted{std::chrono::steady_clock::now()};
+    };
+
+    struct task_scheduler::scheduler {
+        struct scheduled_task {
+            task_scheduler::task fn{};
+            std::shared_ptr<task_scheduler::task_state> state{};
+        };
+
+        // submitted tasks are taken from the front by the owner and thieves alike, continuations are only ever
+        // touched by the owner thread so they keep its connection
+        struct worker_queue {
+            std::mutex mtx;
+            std::deque<scheduled_task> tasks;
+            std::deque<scheduled_task> continuations;
+            connection_pool::lease conn;
+            std::thread thread;
+        };
+
+        connection_pool& pool;
+        task_scheduler::alloc_options opts;
+        std::vector<std::unique_ptr<worker_queue>> workers;
+
+        // idle workers sleep here until a task is queued anywhere
+        std::mutex mtx;
+        std::condition_variable cvar;
+        bool stopping{false};
+        std::atomic<std::size_t> queued{0};
+        std::atomic<std::size_t> pinned{0};
+        std::atomic<std::size_t> next_worker{0};
+        std::atomic<std::uint64_t> executed{0};
+        std::atomic<std::uint64_t> stolen{0};
+
+        scheduler(connection_pool& task_pool, const task_scheduler::alloc_options& options) : pool(task_pool), opts(options) {
+            if (opts.workers == 0)
+                opts.workers = 1;
+
+            workers.reserve(opts.workers);
+            for (std::uint32_t i = 0; i < opts.workers; i++)
+                workers.push_back(std::make_unique<worker_queue>());
+
+            for (std::size_t i = 0; i < workers.size(); i++)
+                workers[i]->thread = std::thread([this, i]() { work(i); });
+        }
+
+        ~scheduler() {
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                stopping = true;
+            }
+            cvar.notify_all();
+
+            for (std::unique_ptr<worker_queue>& w : workers)
+                w->thread.join();
+        }
+
+        // --------------------------------------------------
+        // QUEUES
+        // --------------------------------------------------
+
+        void push(std::size_t index, scheduled_task t) {
+            {
+                std::lock_guard<std::mutex> lock(workers[index]->mtx);
+                workers[index]->tasks.push_back(std::move(t));
+                queued++;
+            }
+
+            // passing through mtx keeps a worker from missing the wakeup between its check and its wait
+            { std::lock_guard<std::mutex> lock(mtx); }
+            cvar.notify_one();
+        }
+
+        void submit(task_scheduler::task t, task_scheduler::completion done) {
+            auto state = std::make_shared<task_scheduler::task_state>();
+            state->done = std::move(done);
+            push(next_worker++ % workers.size(), scheduled_task{std::move(t), std::move(state)});
+        }
+
+        // the worker's own continuations, else the oldest task of its own deque, else the oldest one of the first
+        // busy worker after it
+        bool take(std::size_t self, scheduled_task& next) {
+            worker_queue& w = *workers[self];
+            if (!w.continuations.empty()) {
+                next = std::move(w.continuations.front());
+                w.continuations.pop_front();
+                pinned--;
+                return true;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(w.mtx);
+                if (!w.tasks.empty()) {
+                    next = std::move(w.tasks.front());
+                    w.tasks.pop_front();
+                    queued--;
+                    return true;
+                }
+            }
+
+            for (std::size_t i = 1; i < workers.size(); i++) {
+                worker_queue& victim = *workers[(self + i) % workers.size()];
+                std::lock_guard<std::mutex> lock(victim.mtx);
+                if (!victim.tasks.empty()) {
+                    next = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    queued--;
+                    stolen++;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // --------------------------------------------------
+        // WORKERS
+        // --------------------------------------------------
+
+        // the workers drain every deque before they stop
+        void work(std::size_t self) {
+            while (true) {
+                scheduled_task next;
+                if (take(self, next)) {
+                    execute(self, next);
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(mtx);
+                cvar.wait(lock, [this]() { return stopping || queued > 0; });
+                if (stopping && queued == 0)
+                    break;
+            }
+
+            workers[self]->conn = connection_pool::lease();
+        }
+
+        database_connection* connection(std::size_t self) {
+            worker_queue& w = *workers[self];
+            if (!w.conn.is_valid())
+                w.conn = pool.acquire();
+
+            return w.conn.is_valid() ? &w.conn.connection() : nullptr;
+        }
+
+        // only called on the worker's own thread, which takes the continuation before it sleeps again
+        void then(std::size_t self, const std::shared_ptr<task_scheduler::task_state>& state, task_scheduler::task next) {
+            state->outstanding++;
+            workers[self]->continuations.push_back(scheduled_task{std::move(next), state});
+            pinned++;
+        }
+
+        void execute(std::size_t self, scheduled_task& t) {
+            bool failed_already{false};
+            {
+                std::lock_guard<std::mutex> lock(t.state->mtx);
+                failed_already = !t.state->ok;
+            }
+
+            if (!failed_already && t.fn) {
+                task_scheduler::context ctx(this, self, t.state);
+
+                // a task that throws fails like one that returns false
+                bool ok{false};
+                try {
+                    ok = t.fn(ctx);
+                } catch (...) {
+                    ctx.m_error = simql_strings::from_exception(std::current_exception());
+                }
+                executed++;
+                t.state->tasks++;
+
+                if (!ok) {
+                    std::lock_guard<std::mutex> lock(t.state->mtx);
+                    if (t.state->ok) {
+                        t.state->ok = false;
+                        t.state->error = ctx.m_error.empty() ? std::string{"the task failed"} : std::move(ctx.m_error);
+                    }
+                }
+            }
+
+            // a pending continuation still wants the connection its task used
+            if (!opts.hold_connections && workers[self]->continuations.empty())
+                workers[self]->conn = connection_pool::lease();
+
+            if (--t.state->outstanding == 0)
+                finish(*t.state);
+        }
+
+        void finish(task_scheduler::task_state& state) {
+            task_scheduler::task_result result;
+            {
+                std::lock_guard<std::mutex> lock(state.mtx);
+                result.ok = state.ok;
+                result.error = state.error;
+            }
+            result.tasks = state.tasks;
+            result.elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - state.submitted);
+
+            if (state.done)
+                state.done(std::move(result));
+        }
+
+        task_scheduler::statistics stats() {
+            task_scheduler::statistics s;
+            s.executed = executed;
+            s.stolen = stolen;
+            s.queued = queued + pinned;
+            return s;
+        }
+    };
+
+    // --------------------------------------------------
+    // CONTEXT
+    // --------------------------------------------------
+
+    task_scheduler::context::context(task_scheduler::scheduler* owner, std::size_t worker, std::shared_ptr<task_scheduler::task_state> state) : m_owner(owner), m_worker(worker), m_state(std::move(state)) {}
+
+    database_connection* task_scheduler::context::connection() {
+        return m_owner->connection(m_worker);
+    }
+
+    std::size_t task_scheduler::context::worker() const {
+        return m_worker;
+    }
+
+    void task_scheduler::context::then(task_scheduler::task next) {
+        m_owner->then(m_worker, m_state, std::move(next));
+    }
+
+    void task_scheduler::context::fail(std::string error) {
+        m_error = std::move(error);
+    }
+
+    // --------------------------------------------------
+    // SCHEDULER
+    // --------------------------------------------------
+
+    task_scheduler::task_scheduler(connection_pool& pool, const task_scheduler::alloc_options& options) : m_scheduler(std::make_unique<scheduler>(pool, options)) {}
+
+    task_scheduler::~task_scheduler() = default;
+
+    std::future<task_scheduler::task_result> task_scheduler::submit(task_scheduler::task t) {
+        auto promise = std::make_shared<std::promise<task_scheduler::task_result>>();
+        std::future<task_scheduler::task_result> future = promise->get_future();
+        m_scheduler.get()->submit(std::move(t), [promise](task_scheduler::task_result result) { promise->set_value(std::move(result)); });
+        return future;
+    }
+
+    void task_scheduler::submit(task_scheduler::task t, task_scheduler::completion done) {
+        m_scheduler.get()->submit(std::move(t), std::move(done));
+    }
+
+    std::vector<task_scheduler::task_result> task_scheduler::run(std::vector<task_scheduler::task> batch) {
+        std::vector<std::future<task_scheduler::task_result>> futures;
+        futures.reserve(batch.size());
+        for (task_scheduler::task& t : batch)
+            futures.push_back(submit(std::move(t)));
+
+        std::vector<task_scheduler::task_result> results;
+        results.reserve(futures.size());
+        for (std::future<task_scheduler::task_result>& f : futures)
+            results.push_back(f.get());
+        return results;
+    }
+
+    task_scheduler::statistics task_scheduler::stats() {
+        return m_scheduler.get()->stats();
+    }
+
+}
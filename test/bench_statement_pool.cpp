@@ -0,0 +1,125 @@
+// SimQL stuff
+#include "connection_string_builder.hpp"
+#include "simql_constants.hpp"
+#include "environment.hpp"
+#include "database_connection.hpp"
+#include "statement.hpp"
+#include "statement_pool.hpp"
+#include "diagnostic_set.hpp"
+
+// STL stuff
+#include <string>
+#include <cstdint>
+#include <iostream>
+#include <format>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+
+// secrets
+#include <test_secrets.hpp>
+
+// acquire/release round trips per thread for every thread count
+static constexpr std::uint32_t iterations_per_thread = 100000;
+
+struct bench_result {
+    std::uint64_t operations{0};
+    std::uint64_t exhausted{0};
+    std::chrono::nanoseconds elapsed{};
+    std::chrono::nanoseconds worst{};
+};
+
+bench_result run_contention(simql::statement_pool& pool, std::uint32_t thread_count) {
+    std::atomic<bool> start{false};
+    std::atomic<std::uint64_t> exhausted{0};
+    std::vector<std::chrono::nanoseconds> worst(thread_count);
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count);
+
+    for (std::uint32_t t = 0; t < thread_count; t++) {
+        threads.emplace_back([&, t]() {
+            while (!start.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            for (std::uint32_t i = 0; i < iterations_per_thread; i++) {
+                auto begin = std::chrono::steady_clock::now();
+                simql::statement stmt = pool.acquire();
+                if (!stmt.is_valid())
+                    exhausted.fetch_add(1, std::memory_order_relaxed);
+
+                pool.release(std::move(stmt));
+                worst[t] = std::max(worst[t], std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin));
+            }
+        });
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    start.store(true, std::memory_order_release);
+    for (std::thread& thread : threads)
+        thread.join();
+
+    bench_result result;
+    result.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - begin);
+    result.operations = static_cast<std::uint64_t>(thread_count) * iterations_per_thread;
+    result.exhausted = exhausted.load();
+    result.worst = *std::max_element(worst.begin(), worst.end());
+    return result;
+}
+
+int main() {
+
+    simql::connection_string_builder builder;
+    switch (test_secrets::current_os) {
+    case test_secrets::operating_system::windows:
+        builder.set_db_type(simql::connection_string_builder::database_type::sql_server);
+        builder.set_driver(std::string(simql_constants::database_drivers::odbc_17_sql_server));
+        builder.set_trusted(true);
+        break;
+    case test_secrets::operating_system::linux:
+        builder.set_db_type(simql::connection_string_builder::database_type::postgresql);
+        builder.set_driver(std::string(simql_constants::database_drivers::psql_odbc));
+        builder.set_username(std::string(test_secrets::uid));
+        builder.set_password(std::string(test_secrets::pwd));
+        break;
+    default:
+        return 0;
+    }
+    builder.set_server(std::string(test_secrets::server));
+    builder.set_database(std::string(test_secrets::database));
+    builder.set_port(test_secrets::port);
+
+    // allocate the environment handle
+    simql::environment::alloc_options env_opts;
+    simql::environment env(env_opts);
+    if (!env.is_valid()) {
+        std::cout << "environment alloc error: " << env.last_error() << std::endl;
+        return 1;
+    }
+
+    // open the connection to the database
+    simql::database_connection::alloc_options dbc_opts;
+    simql::database_connection dbc(env, dbc_opts);
+    if (!dbc.is_valid() || !dbc.connect(builder.get())) {
+        std::cout << "database connection error: " << dbc.last_error() << std::endl;
+        return 1;
+    }
+
+    // threads beyond max_size exercise the exhausted path
+    simql::statement::alloc_options stmt_opts;
+    simql::statement_pool::alloc_options pool_opts;
+    pool_opts.acquire_timeout = std::chrono::milliseconds(1000);
+    simql::statement_pool pool(dbc, pool_opts, stmt_opts);
+
+    std::cout << std::format("{:>8} {:>14} {:>12} {:>12} {:>10}", "threads", "ops/s", "ns/op", "worst us", "exhausted") << std::endl;
+    for (std::uint32_t thread_count = 1; thread_count <= 64; thread_count *= 2) {
+        bench_result result = run_contention(pool, thread_count);
+        double seconds = std::chrono::duration<double>(result.elapsed).count();
+        double ops_per_second = seconds > 0 ? static_cast<double>(result.operations) / seconds : 0.0;
+        double ns_per_op = static_cast<double>(result.elapsed.count()) * thread_count / static_cast<double>(result.operations);
+        std::cout << std::format("{:>8} {:>14.0f} {:>12.1f} {:>12.1f} {:>10}", thread_count, ops_per_second, ns_per_op, static_cast<double>(result.worst.count()) / 1000.0, result.exhausted) << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+// SimQL stuff
+#include "simql_queues.hpp"
+
+// STL stuff
+#include <string>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+// values pushed by every producer thread
+static constexpr std::uint32_t values_per_producer = 200000;
+static constexpr std::uint32_t producer_count = 4;
+static constexpr std::uint32_t consumer_count = 4;
+static constexpr std::size_t stress_capacity = 64;
+
+static int failures = 0;
+
+void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::cout << "FAILED: " << what << std::endl;
+        failures++;
+    }
+}
+
+// every producer pushes its own range of values while the consumers pop, each value has to come out exactly once
+// and the size never exceeds the capacity
+template<typename Queue>
+void stress(Queue& queue, const std::string& name) {
+    const std::uint32_t total = producer_count * values_per_producer;
+    std::vector<std::atomic<std::uint8_t>> seen(total);
+    std::atomic<std::uint32_t> popped{0};
+    std::atomic<bool> oversized{false};
+    std::atomic<bool> start{false};
+
+    std::vector<std::thread> threads;
+    for (std::uint32_t p = 0; p < producer_count; p++) {
+        threads.emplace_back([&, p]() {
+            while (!start.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            for (std::uint32_t i = 0; i < values_per_producer; i++) {
+                std::uint32_t value = p * values_per_producer + i;
+                while (!queue.try_push(value))
+                    std::this_thread::yield();
+
+                if (queue.size_approx() > queue.capacity())
+                    oversized.store(true, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    for (std::uint32_t c = 0; c < consumer_count; c++) {
+        threads.emplace_back([&]() {
+            while (!start.load(std::memory_order_acquire))
+                std::this_thread::yield();
+
+            std::uint32_t value{0};
+            while (popped.load(std::memory_order_relaxed) < total) {
+                if (!queue.try_pop(value)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                if (value < total)
+                    seen[value].fetch_add(1, std::memory_order_relaxed);
+                popped.fetch_add(1, std::memory_order_relaxed);
+
+                if (queue.size_approx() > queue.capacity())
+                    oversized.store(true, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    start.store(true, std::memory_order_release);
+    for (std::thread& thread : threads)
+        thread.join();
+
+    std::uint32_t wrong{0};
+    for (std::atomic<std::uint8_t>& count : seen)
+        wrong += count.load() == 1 ? 0 : 1;
+
+    check(popped.load() == total, name + " pops every pushed value");
+    check(wrong == 0, name + " sees each value exactly once");
+    check(!oversized.load(), name + " stays within its capacity");
+    check(queue.size_approx() == 0, name + " is empty once drained");
+}
+
+// a full queue refuses the next push and takes one again after a pop
+template<typename Queue>
+void capacity_bound(Queue& queue, const std::string& name) {
+    std::size_t pushed{0};
+    while (pushed < queue.capacity() && queue.try_push(static_cast<std::uint32_t>(pushed)))
+        pushed++;
+
+    std::uint32_t value{0};
+    check(pushed == queue.capacity(), name + " takes capacity values");
+    check(!queue.try_push(0), name + " refuses a push when full");
+    check(queue.try_pop(value) && queue.try_push(value), name + " takes a push again after a pop");
+
+    while (queue.try_pop(value)) {}
+    check(queue.size_approx() == 0, name + " is empty once drained");
+}
+
+int main() {
+
+    simql_queues::mpmc_ring<std::uint32_t> ring(stress_capacity);
+    capacity_bound(ring, "mpmc_ring");
+    stress(ring, "mpmc_ring");
+
+    simql_queues::lifo_stack<std::uint32_t> stack(stress_capacity);
+    capacity_bound(stack, "lifo_stack");
+    stress(stack, "lifo_stack");
+
+    // the most recently pushed value comes out first, also across interleaved pushes and pops
+    for (std::uint32_t i = 0; i < 8; i++)
+        stack.try_push(i);
+
+    std::uint32_t value{0};
+    bool ordered{true};
+    for (std::uint32_t i = 8; i > 4; i--)
+        ordered = ordered && stack.try_pop(value) && value == i - 1;
+
+    stack.try_push(100);
+    ordered = ordered && stack.try_pop(value) && value == 100;
+    for (std::uint32_t i = 4; i > 0; i--)
+        ordered = ordered && stack.try_pop(value) && value == i - 1;
+    check(ordered && !stack.try_pop(value), "lifo_stack pops in reverse push order");
+
+    if (failures > 0) {
+        std::cout << failures << " queue checks failed" << std::endl;
+        return 1;
+    }
+
+    std::cout << "all queue checks passed" << std::endl;
+    return 0;
+}